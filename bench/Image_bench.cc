@@ -0,0 +1,272 @@
+/**
+ * @file   Image_bench.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmarks for the Image API. Every benchmark is run for each ImageFormat,
+ * image size and (for TDB) CompressionType. Operations are queued lazily, so
+ * the read, crop, resize and threshold benchmarks include reading the image.
+ */
+
+#include <vector>
+
+#include "bench_utils.h"
+#include "Image.h"
+
+using namespace VCL::bench;
+
+namespace {
+
+    struct Params {
+        VCL::ImageFormat format;
+        int size;
+        VCL::CompressionType comp;
+    };
+
+    Params get_params(const benchmark::State &state)
+    {
+        Params p;
+        p.format = VCL::ImageFormat(state.range(0));
+        p.size = state.range(1);
+        p.comp = VCL::CompressionType(state.range(2));
+        return p;
+    }
+
+    VCL::ImageFormat encoded_format(VCL::ImageFormat format)
+    {
+        return format == VCL::TDB ? VCL::PNG : format;
+    }
+}
+
+static void BM_ImageRead(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(p.format, p.size, p.comp);
+
+        for (auto _ : state) {
+            VCL::Image img(path);
+            benchmark::DoNotOptimize(img.get_cvmat());
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageWrite(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        const cv::Mat &source = source_image(p.size);
+        std::string path = output_path(p.format, p.size, p.comp);
+
+        for (auto _ : state) {
+            state.PauseTiming();
+            VCL::Image img(source);
+            img.set_compression(p.comp);
+            state.ResumeTiming();
+
+            img.store(path, p.format);
+
+            // Each TDB write would otherwise add a fragment to the array
+            state.PauseTiming();
+            if ( p.format == VCL::TDB )
+                img.delete_image();
+            state.ResumeTiming();
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageCrop(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(p.format, p.size, p.comp);
+        VCL::Rectangle rect(p.size / 4, p.size / 4, p.size / 2, p.size / 2);
+
+        for (auto _ : state) {
+            VCL::Image img(path);
+            img.crop(rect);
+            benchmark::DoNotOptimize(img.get_cvmat());
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageResize(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(p.format, p.size, p.comp);
+
+        for (auto _ : state) {
+            VCL::Image img(path);
+            img.resize(p.size / 2, p.size / 2);
+            benchmark::DoNotOptimize(img.get_cvmat());
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageThumbnail(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(p.format, p.size, p.comp);
+
+        // JPEG images are decoded at 1/8 of their size for this resize
+        for (auto _ : state) {
+            VCL::Image img(path);
+            img.resize(p.size / 8, p.size / 8);
+            benchmark::DoNotOptimize(img.get_cvmat());
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageThreshold(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(p.format, p.size, p.comp);
+
+        for (auto _ : state) {
+            VCL::Image img(path);
+            img.threshold(128);
+            benchmark::DoNotOptimize(img.get_cvmat());
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageGetCVMat(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        VCL::Image img(fixture_path(p.format, p.size, p.comp));
+        img.get_cvmat();
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(img.get_cvmat());
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageGetRawData(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        VCL::Image img(fixture_path(p.format, p.size, p.comp));
+        img.get_cvmat();
+
+        int length = img.get_raw_data_size();
+        std::vector<unsigned char> buffer(length);
+
+        for (auto _ : state) {
+            img.get_raw_data(buffer.data(), length);
+            benchmark::ClobberMemory();
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+static void BM_ImageGetEncodedImage(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        VCL::Image img(fixture_path(p.format, p.size, p.comp));
+        img.get_cvmat();
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(img.get_encoded_image(encoded_format(p.format)));
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, p.format, p.size, p.comp);
+}
+
+BENCHMARK(BM_ImageRead)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageWrite)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageCrop)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageResize)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageThumbnail)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageThreshold)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageGetCVMat)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageGetRawData)->Apply(format_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImageGetEncodedImage)->Apply(format_args)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,321 @@
+/**
+ * @file   TDBImage_bench.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmarks for TDBImage, run for each image size and CompressionType.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "bench_utils.h"
+#include "TDBImage.h"
+
+using namespace VCL::bench;
+
+namespace {
+
+    struct Params {
+        int size;
+        VCL::CompressionType comp;
+    };
+
+    Params get_params(const benchmark::State &state)
+    {
+        Params p;
+        p.size = state.range(0);
+        p.comp = VCL::CompressionType(state.range(1));
+        return p;
+    }
+
+    // Length of the regions read by the tiling benchmark
+    const int region_length = 256;
+    const int num_regions = 16;
+
+    /**
+     *  Registers one set of arguments per (size, policy, pattern)
+     *    combination: { size, TilingPolicy, regions }. Regions is 0
+     *    when the whole image is read. A prime size is added to show
+     *    the padding of the different policies
+     */
+    void tiling_args(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({ "size", "tiling", "regions" });
+
+        std::vector<int> sizes = image_sizes;
+        sizes.push_back(4093);
+
+        for ( int size : sizes ) {
+            for ( int policy = 0; policy <= int(VCL::TilingPolicy::REGION_READS);
+                    ++policy ) {
+                b->Args({ size, policy, 0 });
+                b->Args({ size, policy, num_regions });
+            }
+        }
+    }
+}
+
+static void BM_TDBImageWrite(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        const cv::Mat &source = source_image(p.size);
+        std::string path = output_path(VCL::TDB, p.size, p.comp);
+
+        for (auto _ : state) {
+            VCL::TDBImage tdb(path);
+            tdb.set_compression(p.comp);
+            tdb.write(source);
+
+            state.PauseTiming();
+            tdb.delete_image();
+            state.ResumeTiming();
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+static void BM_TDBImageRead(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(VCL::TDB, p.size, p.comp);
+
+        for (auto _ : state) {
+            VCL::TDBImage tdb(path);
+            tdb.read();
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+static void BM_TDBImageReadRectangle(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(VCL::TDB, p.size, p.comp);
+        VCL::Rectangle rect(p.size / 4, p.size / 4, p.size / 2, p.size / 2);
+
+        for (auto _ : state) {
+            VCL::TDBImage tdb(path);
+            tdb.read(rect);
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+static void BM_TDBImageResize(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        std::string path = fixture_path(VCL::TDB, p.size, p.comp);
+        VCL::Rectangle rect(0, 0, p.size / 2, p.size / 2);
+
+        for (auto _ : state) {
+            state.PauseTiming();
+            VCL::TDBImage tdb(path);
+            tdb.read();
+            state.ResumeTiming();
+
+            tdb.resize(rect);
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+static void BM_TDBImageThreshold(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        VCL::TDBImage tdb(fixture_path(VCL::TDB, p.size, p.comp));
+        tdb.read();
+
+        for (auto _ : state)
+            tdb.threshold(128);
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+// The threshold is applied to each strip as it is read, compare with
+// BM_TDBImageRead plus BM_TDBImageThreshold
+static void BM_TDBImageThresholdOnRead(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        for (auto _ : state) {
+            VCL::TDBImage tdb(fixture_path(VCL::TDB, p.size, p.comp));
+            tdb.threshold(128);
+            tdb.read();
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+static void BM_TDBImageGetCVMat(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        VCL::TDBImage tdb(fixture_path(VCL::TDB, p.size, p.comp));
+        tdb.read();
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(tdb.get_cvmat());
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+static void BM_TDBImageGetBuffer(benchmark::State &state)
+{
+    Params p = get_params(state);
+
+    try {
+        VCL::TDBImage tdb(fixture_path(VCL::TDB, p.size, p.comp));
+        tdb.read();
+
+        int length = tdb.get_image_size();
+        std::vector<unsigned char> buffer(length);
+
+        for (auto _ : state) {
+            tdb.get_buffer(buffer.data(), length);
+            benchmark::ClobberMemory();
+        }
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, p.size, p.comp);
+}
+
+static void BM_TDBImageTiling(benchmark::State &state)
+{
+    int size = state.range(0);
+    VCL::TilingPolicy policy = VCL::TilingPolicy(state.range(1));
+    int regions = state.range(2);
+    VCL::CompressionType comp = VCL::CompressionType::LZ4;
+    int length = std::min(region_length, size);
+
+    try {
+        std::string path = output_path(VCL::TDB, size, comp);
+        path.insert(path.size() - 4, "_tiling" + std::to_string(state.range(1)));
+
+        VCL::TDBImage stored(path);
+        stored.set_compression(comp);
+        stored.set_tiling(policy,
+            policy == VCL::TilingPolicy::FACTOR ? 0 : length);
+        stored.write(source_image(size));
+
+        // The same regions are read in every iteration
+        std::mt19937 generator(size);
+        std::uniform_int_distribution<int> offset(0, size - length);
+        std::vector<VCL::Rectangle> rects;
+        for ( int i = 0; i < regions; ++i )
+            rects.push_back(VCL::Rectangle(offset(generator),
+                offset(generator), length, length));
+
+        for (auto _ : state) {
+            if ( regions == 0 ) {
+                VCL::TDBImage tdb(path);
+                tdb.read();
+            }
+            for ( const VCL::Rectangle &rect : rects ) {
+                VCL::TDBImage tdb(path);
+                tdb.read(rect);
+            }
+        }
+
+        stored.delete_image();
+    }
+    catch ( VCL::Exception &e ) {
+        state.SkipWithError(e.msg.c_str());
+        return;
+    }
+
+    set_counters(state, VCL::TDB, size, comp);
+
+    // Only the regions are read, not the whole image
+    if ( regions > 0 ) {
+        int64_t bytes = int64_t(regions) * length * length
+            * source_image(size).channels();
+        state.SetBytesProcessed(int64_t(state.iterations()) * bytes);
+    }
+}
+
+BENCHMARK(BM_TDBImageWrite)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageRead)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageReadRectangle)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageResize)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageThreshold)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageThresholdOnRead)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageGetCVMat)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageGetBuffer)->Apply(compression_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TDBImageTiling)->Apply(tiling_args)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,168 @@
+/**
+ * @file   bench_utils.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <map>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "bench_utils.h"
+#include "Exception.h"
+
+namespace VCL {
+namespace bench {
+
+    const std::vector<int> image_sizes = { 256, 1024, 4096 };
+
+    const int num_compressions = int(CompressionType::RLE) + 1;
+
+    // Benchmarks are run from the bench directory, like the unit tests
+    // are run from the test directory
+    static const std::string source_file = "../test/images/large1.jpg";
+    static const std::string image_dir = "images/";
+    static const std::string tdb_dir = "tdb/bench/";
+
+    static std::string format_name(ImageFormat format)
+    {
+        switch ( format ) {
+            case VCL::JPG:
+                return "jpg";
+            case VCL::PNG:
+                return "png";
+            case VCL::TDB:
+                return "tdb";
+            default:
+                return "";
+        }
+    }
+
+    static std::string compression_name(CompressionType comp)
+    {
+        static const char* names[] = { "none", "gzip", "zstd", "lz4", "blosc",
+            "blz4", "blz4hc", "bsnappy", "bzlib", "bzstd", "rle" };
+
+        return names[int(comp)];
+    }
+
+    static std::string image_name(ImageFormat format, int size,
+        CompressionType comp)
+    {
+        std::string name = std::to_string(size);
+
+        if ( format == VCL::TDB )
+            name += "_" + compression_name(comp);
+
+        return name + "." + format_name(format);
+    }
+
+    void format_args(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({ "format", "size", "compression" });
+
+        for ( int size : image_sizes ) {
+            b->Args({ VCL::JPG, size, 0 });
+            b->Args({ VCL::PNG, size, 0 });
+            for ( int comp = 0; comp < num_compressions; ++comp )
+                b->Args({ VCL::TDB, size, comp });
+        }
+    }
+
+    void compression_args(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({ "size", "compression" });
+
+        for ( int size : image_sizes ) {
+            for ( int comp = 0; comp < num_compressions; ++comp )
+                b->Args({ size, comp });
+        }
+    }
+
+    const cv::Mat& source_image(int size)
+    {
+        static std::map<int, cv::Mat> images;
+
+        std::map<int, cv::Mat>::iterator it = images.find(size);
+        if ( it != images.end() )
+            return it->second;
+
+        cv::Mat source = cv::imread(source_file, cv::IMREAD_ANYCOLOR);
+        if ( source.empty() )
+            throw VCLException(ObjectEmpty, source_file + " could not be read");
+
+        cv::Mat resized;
+        cv::resize(source, resized, cv::Size(size, size));
+
+        return images[size] = resized;
+    }
+
+    std::string fixture_path(ImageFormat format, int size,
+        CompressionType comp)
+    {
+        static std::map<std::string, bool> written;
+
+        std::string dir = format == VCL::TDB ? tdb_dir : image_dir;
+        std::string path = dir + image_name(format, size, comp);
+
+        if ( written.find(path) == written.end() ) {
+            mkdir(image_dir.c_str(), 0777);
+
+            Image img(source_image(size));
+            img.set_compression(comp);
+            img.store(path, format);
+
+            written[path] = true;
+        }
+
+        return path;
+    }
+
+    std::string output_path(ImageFormat format, int size,
+        CompressionType comp)
+    {
+        std::string dir = format == VCL::TDB ? tdb_dir : image_dir;
+        mkdir(image_dir.c_str(), 0777);
+
+        return dir + "out_" + image_name(format, size, comp);
+    }
+
+    void set_counters(benchmark::State &state, ImageFormat format, int size,
+        CompressionType comp)
+    {
+        std::string label = format_name(format);
+        if ( format == VCL::TDB )
+            label += "/" + compression_name(comp);
+        state.SetLabel(label);
+
+        int64_t bytes = int64_t(size) * size * source_image(size).channels();
+        state.SetBytesProcessed(int64_t(state.iterations()) * bytes);
+    }
+};
+};
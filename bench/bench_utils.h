@@ -0,0 +1,114 @@
+/**
+ * @file   bench_utils.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the helpers shared by the VCL benchmarks: the image sizes
+ * and compression types to sweep, and the fixture images each benchmark reads.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core.hpp>
+
+#include "Image.h"
+
+namespace VCL {
+namespace bench {
+
+    /** Edge length (in pixels) of the square images to benchmark */
+    extern const std::vector<int> image_sizes;
+
+    /** Number of CompressionType values (NOCOMPRESSION through RLE) */
+    extern const int num_compressions;
+
+    /**
+     *  Registers one set of arguments per (format, size, compression)
+     *    combination: { ImageFormat, size, CompressionType }. JPG and
+     *    PNG are only registered with NOCOMPRESSION since compression
+     *    applies to TDB only
+     *
+     *  @param b  The benchmark to register the arguments on
+     */
+    void format_args(benchmark::internal::Benchmark* b);
+
+    /**
+     *  Registers one set of arguments per (size, compression)
+     *    combination: { size, CompressionType }
+     *
+     *  @param b  The benchmark to register the arguments on
+     */
+    void compression_args(benchmark::internal::Benchmark* b);
+
+    /**
+     *  Gets the source image resized to size x size
+     *
+     *  @param size  The number of rows and columns
+     *  @return An OpenCV Mat of the requested size
+     */
+    const cv::Mat& source_image(int size);
+
+    /**
+     *  Gets the path of an image of the given format, size and
+     *    compression, writing it the first time it is requested
+     *
+     *  @param format  The ImageFormat of the stored image
+     *  @param size  The number of rows and columns
+     *  @param comp  The compression type (used for TDB only)
+     *  @return The full path to the stored image
+     */
+    std::string fixture_path(ImageFormat format, int size,
+        CompressionType comp);
+
+    /**
+     *  Gets a path benchmarks can write to for the given format,
+     *    size and compression
+     *
+     *  @param format  The ImageFormat of the image to write
+     *  @param size  The number of rows and columns
+     *  @param comp  The compression type (used for TDB only)
+     *  @return The full path to write to
+     */
+    std::string output_path(ImageFormat format, int size,
+        CompressionType comp);
+
+    /**
+     *  Sets the label and the bytes processed of a benchmark
+     *
+     *  @param state  The benchmark state
+     *  @param format  The ImageFormat being benchmarked
+     *  @param size  The number of rows and columns
+     *  @param comp  The compression type
+     */
+    void set_counters(benchmark::State &state, ImageFormat format, int size,
+        CompressionType comp);
+};
+};
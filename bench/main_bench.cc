@@ -0,0 +1,58 @@
+/**
+ * @file   main_bench.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+int main(int argc, char** argv)
+{
+    // Results are written as JSON unless the caller picks another output
+    static char out_file[] = "--benchmark_out=vcl_bench.json";
+    static char out_format[] = "--benchmark_out_format=json";
+
+    std::vector<char*> args(argv, argv + argc);
+
+    bool has_out = false;
+    for ( int i = 1; i < argc; ++i ) {
+        if ( std::strncmp(argv[i], "--benchmark_out=", 16) == 0 )
+            has_out = true;
+    }
+
+    if ( !has_out ) {
+        args.push_back(out_file);
+        args.push_back(out_format);
+    }
+
+    int count = args.size();
+    benchmark::Initialize(&count, args.data());
+    benchmark::RunSpecifiedBenchmarks();
+
+    return 0;
+}
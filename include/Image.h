@@ -44,6 +44,7 @@
 
 namespace VCL {
     class ImageData;
+    class PatchIterator;
 
     /*  *********************** */
     /*        IMAGEFORMAT       */
@@ -67,6 +68,14 @@ namespace VCL {
         // Pointer to an ImageData object
         ImageData *_image;
 
+        /**
+         *  Creates an Image object that takes ownership of an
+         *    existing ImageData object
+         *
+         *  @param image  A pointer to an ImageData object
+         */
+        Image(ImageData *image);
+
     public:
     /*  *********************** */
     /*        CONSTRUCTORS      */
@@ -124,6 +133,24 @@ namespace VCL {
          */
         void operator=(const Image &img);
 
+        /**
+         *  Creates a new Image object by taking over the data of an
+         *    existing Image object, without copying it
+         *
+         *  @param img  The Image object to move from, which can only be
+         *    assigned to or destroyed afterwards
+         */
+        Image(Image &&img) noexcept;
+
+        /**
+         *  Sets an Image object to the data of another Image object,
+         *    without copying it
+         *
+         *  @param img  The Image object to move from
+         *  @return The current Image object
+         */
+        Image& operator=(Image &&img) noexcept;
+
         ~Image();
 
     /*  *********************** */
@@ -176,7 +203,21 @@ namespace VCL {
         Image get_area(const Rectangle &roi) const;
 
         /**
-         *  Gets an OpenCV Mat that contains the image data
+         *  Gets an iterator over fixed size patches of the image, row by
+         *    row. A TDB image that has not been read yet is read a row of
+         *    tiles at a time, each tile once, instead of once per patch
+         *
+         *  @param size  The size of the patches
+         *  @param stride  The distance between neighboring patches
+         *  @return A PatchIterator positioned at the first patch
+         *  @see PatchIterator.h for details on iterating
+         */
+        PatchIterator get_patches(cv::Size size, cv::Size stride) const;
+
+        /**
+         *  Gets an OpenCV Mat that contains the image data. The Mat
+         *    shares the data held by the Image, so repeated calls do
+         *    not copy the image; clone the Mat before modifying it
          *
          *  @return An OpenCV Mat
          */
@@ -227,6 +268,38 @@ namespace VCL {
          */
         void set_compression(CompressionType comp);
 
+        /**
+         *  Sets the number of downsampled levels (1/2, 1/4, ...) stored
+         *    along with the image when it is stored in TDB format. Resizing
+         *    a stored image then reads the closest level instead of the
+         *    full resolution data
+         *
+         *  @param levels  The number of pyramid levels, 0 for none
+         */
+        void set_pyramid_levels(int levels);
+
+        /**
+         *  Sets how the tiles are sized when the image is stored in TDB
+         *    format. Whole image reads favor large tiles, while reads of
+         *    small regions favor tiles about the size of the regions
+         *
+         *  @param policy  The TilingPolicy, FACTOR by default
+         *  @param size  The tile length for FIXED, or the length of the
+         *    regions expected to be read for REGION_READS (256 if 0)
+         *  @see utils.h for details on TilingPolicy
+         */
+        void set_tiling(TilingPolicy policy, int size = 0);
+
+        /**
+         *  Sets whether JPG and PNG files are read once from start to
+         *    end, as in batch jobs. Files are memory mapped and decoded
+         *    from the mapping, this advises the kernel to read ahead more
+         *    and drop the pages sooner
+         *
+         *  @param sequential  Whether to give the sequential hint
+         */
+        void set_sequential_read(bool sequential);
+
         /**
          *  Sets the size of the image in pixels (width, height) using
          *    an OpenCV Size object
@@ -246,6 +319,13 @@ namespace VCL {
 
         void set_minimum_dimension(int dimension);
 
+        /**
+         *  Sets the number of threads used when reading a TDB image
+         *
+         *  @param threads  The number of threads, 0 uses the OpenMP default
+         */
+        void set_num_threads(int threads);
+
     /*  *********************** */
     /*    IMAGE INTERACTIONS    */
     /*  *********************** */
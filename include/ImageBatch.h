@@ -0,0 +1,180 @@
+/**
+ * @file   ImageBatch.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the C++ API for ImageBatch, which stores many images
+ * in one call using a pool of worker threads
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Image.h"
+#include "utils.h"
+
+namespace VCL {
+
+    class ImageBatch {
+
+    public:
+        /**
+         *  The outcome of storing one image of the batch
+         */
+        struct Status {
+            std::string image_id;   // Where the image was to be stored
+            bool stored;            // Whether the image was stored
+            std::string error;      // Why the image was not stored
+            size_t bytes;           // Size of the raw pixel data stored
+            double seconds;         // Time spent on the image
+        };
+
+    private:
+    /*  *********************** */
+    /*        VARIABLES         */
+    /*  *********************** */
+        // An image waiting to be stored, either a path or an Image
+        struct Entry {
+            std::string source_id;
+            std::shared_ptr<Image> image;
+            std::string image_id;
+        };
+
+        std::vector<Entry> _entries;
+        std::vector<Status> _status;
+
+        CompressionType _compress;
+        int _num_threads;
+
+        // Totals for the last call to store
+        double _seconds;
+        size_t _bytes;
+
+    public:
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+        /**
+         *  Creates an empty ImageBatch
+         */
+        ImageBatch();
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Gets the number of images waiting to be stored
+         *
+         *  @return The number of images added since the last store
+         */
+        int size() const;
+
+        /**
+         *  Gets the status of every image of the last call to store,
+         *    in the order the images were added
+         *
+         *  @return A vector with one Status per image
+         */
+        const std::vector<Status>& get_status() const;
+
+        /**
+         *  Gets the number of images stored by the last call to store
+         *
+         *  @return The number of images stored without error
+         */
+        int get_num_stored() const;
+
+        /**
+         *  Gets the throughput of the last call to store
+         *
+         *  @return The number of images stored per second
+         */
+        double get_images_per_second() const;
+
+        /**
+         *  Gets the throughput of the last call to store
+         *
+         *  @return The number of raw pixel bytes stored per second
+         */
+        double get_bytes_per_second() const;
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Sets the type of compression used for every image of the batch.
+         *    Currently applicable only to TileDB
+         *
+         *  @param comp  The compression type
+         */
+        void set_compression(CompressionType comp);
+
+        /**
+         *  Sets the number of images stored at the same time. Each worker
+         *    holds at most one decoded image, which bounds the memory used
+         *
+         *  @param threads  The number of threads, 0 uses the OpenMP default
+         */
+        void set_num_threads(int threads);
+
+    /*  *********************** */
+    /*   IMAGEBATCH INTERACTION */
+    /*  *********************** */
+        /**
+         *  Adds an image on the file system to the batch. It is read by
+         *    the worker that stores it
+         *
+         *  @param source_id  Full path to the image to read
+         *  @param image_id  Full path to where the image should be written
+         */
+        void add(const std::string &source_id, const std::string &image_id);
+
+        /**
+         *  Adds an Image to the batch, including any operations queued on
+         *    it. The Image is released as soon as it is stored
+         *
+         *  @param image  The Image to store, moved in to avoid a copy
+         *  @param image_id  Full path to where the image should be written
+         */
+        void add(Image image, const std::string &image_id);
+
+        /**
+         *  Stores all the images added to the batch and empties it. An
+         *    image that fails does not stop the others, its Status holds
+         *    the error
+         *
+         *  @param image_format  Format in which to write the images.
+         *    Defaults to TDB
+         *  @param store_metadata  Flag to indicate whether to store the
+         *    image metadata. Defaults to true
+         */
+        void store(ImageFormat image_format = TDB, bool store_metadata = true);
+    };
+};
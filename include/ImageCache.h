@@ -0,0 +1,195 @@
+/**
+ * @file   ImageCache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the C++ API for ImageCache, a size bounded LRU cache
+ * of decoded images shared by the process. Images read from JPG and PNG
+ * files are kept along with the operations applied to them, so repeated
+ * requests for the same result skip the decode
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <opencv2/core.hpp>
+
+namespace VCL {
+
+    class ImageCache {
+
+    /*  *********************** */
+    /*        VARIABLES         */
+    /*  *********************** */
+        struct Entry {
+            std::string key;
+            cv::Mat image;          // Shared, never modified in place
+            size_t size;            // Bytes of pixel data
+        };
+
+        std::mutex _lock;
+
+        // Most recently used first, indexed by key
+        std::list<Entry> _entries;
+        std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+
+        size_t _capacity;
+        size_t _size;
+
+        uint64_t _hits;
+        uint64_t _misses;
+        uint64_t _evictions;
+
+    protected:
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+        /**
+         *  Creates an empty, disabled cache. Process wide caches of
+         *    other images (such as TDBTileCache) extend ImageCache
+         */
+        ImageCache();
+
+        ImageCache(const ImageCache &cache) = delete;
+        ImageCache& operator=(const ImageCache &cache) = delete;
+
+    public:
+        /**
+         *  Gets the cache used by all Images in the process
+         *
+         *  @return The process wide ImageCache
+         */
+        static ImageCache& instance();
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Gets the maximum number of bytes of pixel data cached
+         *
+         *  @return The capacity in bytes, 0 if the cache is disabled
+         */
+        size_t get_capacity();
+
+        /**
+         *  Gets the number of bytes of pixel data currently cached
+         *
+         *  @return The size in bytes
+         */
+        size_t get_size();
+
+        /**
+         *  Gets the number of images currently cached
+         *
+         *  @return The number of images
+         */
+        int get_num_entries();
+
+        /**
+         *  Gets the number of lookups that found an image
+         *
+         *  @return The number of hits since the last reset
+         */
+        uint64_t get_hits();
+
+        /**
+         *  Gets the number of lookups that did not find an image
+         *
+         *  @return The number of misses since the last reset
+         */
+        uint64_t get_misses();
+
+        /**
+         *  Gets the number of images removed to make room for others
+         *
+         *  @return The number of evictions since the last reset
+         */
+        uint64_t get_evictions();
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Sets the maximum number of bytes of pixel data cached,
+         *    evicting the least recently used images if needed. The
+         *    cache is disabled (the default) with a capacity of 0
+         *
+         *  @param bytes  The capacity in bytes
+         */
+        void set_capacity(size_t bytes);
+
+        /**
+         *  Sets the hit, miss and eviction counters back to 0
+         */
+        void reset_counters();
+
+    /*  *********************** */
+    /*    CACHE INTERACTION     */
+    /*  *********************** */
+        /**
+         *  Gets an image from the cache and marks it as the most
+         *    recently used
+         *
+         *  @param key  The key the image was cached with
+         *  @param image  Set to the cached image if found. It shares
+         *    the cached data, so it must not be modified in place
+         *  @return Whether the image was found
+         */
+        bool get(const std::string &key, cv::Mat &image);
+
+        /**
+         *  Adds an image to the cache, evicting the least recently used
+         *    images if needed. Images larger than the capacity are not
+         *    cached
+         *
+         *  @param key  The key to cache the image with
+         *  @param image  The image, shared with the cache
+         */
+        void put(const std::string &key, const cv::Mat &image);
+
+        /**
+         *  Removes all the images from the cache
+         */
+        void clear();
+
+    private:
+        /**
+         *  Removes the least recently used images until the size is
+         *    within the capacity. Expects the lock to be held
+         *
+         *  @param capacity  The size to get down to
+         */
+        void evict(size_t capacity);
+    };
+};
@@ -0,0 +1,188 @@
+/**
+ * @file   PatchIterator.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the C++ API for PatchIterator, which yields fixed size
+ * patches of an image with a given stride. Images stored in TDB format are
+ * read a row of tiles at a time, with the next row read in the background
+ */
+
+#pragma once
+
+#include <future>
+#include <map>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "Image.h"
+
+namespace VCL {
+
+    class PatchIterator {
+
+    /*  *********************** */
+    /*        VARIABLES         */
+    /*  *********************** */
+        cv::Size _patch_size;
+        cv::Size _stride;
+        cv::Size _dimensions;
+        int _cv_type;
+
+        // Area of the current patch, past the last row when done
+        Rectangle _area;
+        cv::Mat _patch;
+
+        // Images in memory
+        cv::Mat _image;
+
+        // Images stored in TDB format, as rows of tiles by index
+        std::string _tdb_id;
+        int _num_threads;
+        int _tile_height;
+        std::map<int, cv::Mat> _tile_rows;
+
+        std::future<cv::Mat> _prefetch;
+        int _prefetch_row;
+
+    public:
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+        /**
+         *  Creates a PatchIterator over an image in memory, positioned
+         *    at the first patch
+         *
+         *  @param image  The image, shared with the patches
+         *  @param size  The size of the patches
+         *  @param stride  The distance between neighboring patches
+         */
+        PatchIterator(const cv::Mat &image, cv::Size size, cv::Size stride);
+
+        /**
+         *  Creates a PatchIterator over an image stored in TDB format,
+         *    positioned at the first patch. The rows of tiles under the
+         *    patches are each read once
+         *
+         *  @param image_id  The full path to the TDB image
+         *  @param size  The size of the patches
+         *  @param stride  The distance between neighboring patches
+         *  @param num_threads  The number of threads reading each row of
+         *    tiles, 0 uses the OpenMP default
+         */
+        PatchIterator(const std::string &image_id, cv::Size size,
+            cv::Size stride, int num_threads = 0);
+
+        PatchIterator(const PatchIterator &it) = delete;
+        PatchIterator& operator=(const PatchIterator &it) = delete;
+
+        PatchIterator(PatchIterator &&it) = default;
+        PatchIterator& operator=(PatchIterator &&it) = default;
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Gets the number of patches the image is split into. Patches
+         *    only cover whole windows, so the last rows and columns of
+         *    the image may not be part of any
+         *
+         *  @return The number of patches
+         */
+        int get_num_patches() const;
+
+        /**
+         *  Gets the area of the image the current patch covers
+         *
+         *  @return The area of the current patch
+         */
+        Rectangle get_area() const;
+
+        /**
+         *  Gets the pixels of the current patch. The Mat may share the
+         *    data read for neighboring patches, so it must not be
+         *    modified in place
+         *
+         *  @return An OpenCV Mat of the patch
+         */
+        cv::Mat get_patch() const;
+
+    /*  *********************** */
+    /*        ITERATION         */
+    /*  *********************** */
+        /**
+         *  Checks whether the iterator is past the last patch
+         *
+         *  @return Whether all the patches were visited
+         */
+        bool end() const;
+
+        /**
+         *  Moves to the next patch, along the row of patches and then
+         *    down to the next row
+         */
+        void next();
+
+    private:
+        /**
+         *  Sets the size and stride, checking they fit the image
+         *
+         *  @param size  The size of the patches
+         *  @param stride  The distance between neighboring patches
+         */
+        void set_window(cv::Size size, cv::Size stride);
+
+        /**
+         *  Makes the pixels of the current area the current patch,
+         *    loading the rows of tiles it covers if needed
+         */
+        void load_patch();
+
+        /**
+         *  Makes sure the rows of tiles under a row of patches are
+         *    loaded, releasing the rows above it and starting to read
+         *    the next row needed in the background
+         *
+         *  @param row  The first row of pixels of the patches
+         */
+        void load_tile_rows(int row);
+
+        /**
+         *  Reads a row of tiles of a TDB image. Does not use the
+         *    iterator, so it can run in the background while the
+         *    iterator is moved
+         *
+         *  @param image_id  The full path to the TDB image
+         *  @param area  The area of the row of tiles
+         *  @param num_threads  The number of threads reading the row
+         *  @return  The pixels of the row of tiles
+         */
+        static cv::Mat read_tile_row(const std::string &image_id,
+            Rectangle area, int num_threads);
+    };
+};
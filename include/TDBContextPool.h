@@ -0,0 +1,155 @@
+/**
+ * @file   TDBContextPool.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the C++ API for TDBContextPool, which shares TileDB
+ * contexts between TDBObjects instead of creating one per object
+ */
+
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef struct TileDB_CTX TileDB_CTX;
+
+namespace VCL {
+
+    class TDBContextPool {
+
+    public:
+    /*  *********************** */
+    /*         POLICIES         */
+    /*  *********************** */
+        /**
+         *  Determines which TDBObjects share a TileDB context
+         */
+        enum Affinity {
+            SHARED,         // One context for the whole process
+            PER_THREAD      // One context per thread creating TDBObjects
+        };
+
+        /**
+         *  Determines when an unused TileDB context is finalized
+         */
+        enum Lifetime {
+            PROCESS,        // Kept until the process exits
+            REFCOUNTED      // Finalized when the last TDBObject releases it
+        };
+
+    private:
+    /*  *********************** */
+    /*        VARIABLES         */
+    /*  *********************** */
+        struct Context {
+            TileDB_CTX* ctx;
+            std::thread::id owner;  // Default id when shared
+            int users;
+            bool stale;             // Created under a previous affinity
+        };
+
+        std::mutex _lock;
+        std::vector<Context> _contexts;
+
+        Affinity _affinity;
+        Lifetime _lifetime;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+        TDBContextPool();
+        ~TDBContextPool();
+
+        TDBContextPool(const TDBContextPool &pool) = delete;
+        TDBContextPool& operator=(const TDBContextPool &pool) = delete;
+
+    public:
+        /**
+         *  Gets the pool used by all TDBObjects in the process
+         *
+         *  @return The process wide TDBContextPool
+         */
+        static TDBContextPool& instance();
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Gets the number of TileDB contexts currently held by the pool
+         *
+         *  @return The number of contexts, in use or idle
+         */
+        int get_num_contexts();
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Sets how contexts are shared and how long they live. Contexts
+         *    in use keep working, but are finalized once released if they
+         *    do not match the new affinity. Defaults to SHARED and PROCESS
+         *
+         *  @param affinity  Which TDBObjects share a context
+         *  @param lifetime  When an unused context is finalized. Use
+         *    REFCOUNTED with PER_THREAD when threads are short lived
+         */
+        void configure(Affinity affinity, Lifetime lifetime);
+
+    /*  *********************** */
+    /*    POOL INTERACTION      */
+    /*  *********************** */
+        /**
+         *  Gets a TileDB context for the calling thread, creating
+         *    it if needed
+         *
+         *  @return A TileDB context, to be given back with release
+         */
+        TileDB_CTX* acquire();
+
+        /**
+         *  Gives back a TileDB context obtained with acquire. May be
+         *    called from any thread
+         *
+         *  @param ctx  The TileDB context
+         */
+        void release(TileDB_CTX* ctx);
+
+        /**
+         *  Finalizes all the contexts that are not in use
+         */
+        void clear();
+
+    private:
+        /**
+         *  Finalizes unused contexts that the current policies do not
+         *    keep. Expects the lock to be held
+         */
+        void trim();
+    };
+};
@@ -0,0 +1,116 @@
+/**
+ * @file   TDBMetadataCache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the C++ API for TDBMetadataCache, which keeps the
+ * properties of the TDB objects read or written by the process so they
+ * are only read from TileDB once
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace VCL {
+
+    class TDBMetadataCache {
+
+    /*  *********************** */
+    /*        VARIABLES         */
+    /*  *********************** */
+        std::mutex _lock;
+
+        // Properties of each TDB object, by the full path of its array
+        std::map<std::string, std::vector<int64_t>> _properties;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+        TDBMetadataCache() = default;
+
+        TDBMetadataCache(const TDBMetadataCache &cache) = delete;
+        TDBMetadataCache& operator=(const TDBMetadataCache &cache) = delete;
+
+    public:
+        /**
+         *  Gets the cache used by all TDBObjects in the process
+         *
+         *  @return The process wide TDBMetadataCache
+         */
+        static TDBMetadataCache& instance();
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Gets the properties cached for a TDB object
+         *
+         *  @param object_id  The full path of the TDB object
+         *  @param properties  Filled with the cached properties if found
+         *  @return Whether the object was in the cache
+         */
+        bool get(const std::string &object_id, std::vector<int64_t> &properties);
+
+        /**
+         *  Gets the number of TDB objects in the cache
+         *
+         *  @return The number of cached objects
+         */
+        int get_num_entries();
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Sets the properties of a TDB object, replacing any cached ones
+         *
+         *  @param object_id  The full path of the TDB object
+         *  @param properties  The properties read or written
+         */
+        void set(const std::string &object_id,
+            const std::vector<int64_t> &properties);
+
+        /**
+         *  Removes a TDB object from the cache, when it is deleted
+         *
+         *  @param object_id  The full path of the TDB object
+         */
+        void erase(const std::string &object_id);
+
+        /**
+         *  Removes all the TDB objects from the cache. Needed when
+         *    another process may have rewritten them
+         */
+        void clear();
+    };
+};
@@ -0,0 +1,61 @@
+/**
+ * @file   TDBTileCache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the C++ API for TDBTileCache, a size bounded LRU cache
+ * of the decompressed tiles of TDB images shared by the process. Reads of
+ * overlapping areas of an image only fetch the tiles that are not cached
+ */
+
+#pragma once
+
+#include "ImageCache.h"
+
+namespace VCL {
+
+    /**
+     *  Caches tiles keyed by the array path, the set of fragments of the
+     *    array (which changes when it is written) and the tile position.
+     *    Disabled until it is given a capacity
+     */
+    class TDBTileCache : public ImageCache {
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+        TDBTileCache() = default;
+
+    public:
+        /**
+         *  Gets the cache used by all TDBImages in the process
+         *
+         *  @return The process wide TDBTileCache
+         */
+        static TDBTileCache& instance();
+    };
+};
@@ -33,4 +33,10 @@
 
 #include "Exception.h"
 #include "Image.h"
+#include "ImageCache.h"
+#include "ImageBatch.h"
+#include "PatchIterator.h"
+#include "TDBContextPool.h"
+#include "TDBMetadataCache.h"
+#include "TDBTileCache.h"
 
@@ -54,6 +54,18 @@ namespace VCL {
                     BZSTD = 9,
                     RLE = 10, };
 
+    /**
+     *  Determines how the tile extents of a TDB object are chosen.
+     *    FACTOR uses the greatest factor of each dimension, FIXED uses
+     *    square tiles of a given size, and FULL_READS and REGION_READS
+     *    choose square tiles that minimize the data read when the whole
+     *    object or regions of a given size are read
+     */
+    enum class TilingPolicy : int { FACTOR = 0,
+                    FIXED = 1,
+                    FULL_READS = 2,
+                    REGION_READS = 3, };
+
 
     static const struct init_rand_t { init_rand_t() { srand(time(NULL)); } } init_rand;
 
@@ -61,6 +73,12 @@ namespace VCL {
 
     bool supports_rdrand();
 
+    bool supports_ssse3();
+
+    bool supports_sse41();
+
+    bool supports_avx2();
+
     uint64_t get_int64();
 
 };
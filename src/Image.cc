@@ -28,10 +28,12 @@
  */
 
 #include <stddef.h>
+#include <utility>
 
 #include "Image.h"
 #include "Exception.h"
 #include "ImageData.h"
+#include "PatchIterator.h"
 
 using namespace VCL;
 
@@ -77,9 +79,32 @@ Image::Image(const Image &img)
 
 void Image::operator=(const Image &img)
 {
-    ImageData *temp = _image;
-    _image = new ImageData(*img._image);
-    delete temp;
+    if ( this == &img )
+        return;
+
+    // A moved from Image has no ImageData left to assign to
+    if ( _image == NULL )
+        _image = new ImageData(*img._image);
+    else
+        *_image = *img._image;
+}
+
+Image::Image(Image &&img) noexcept
+    : _image(img._image)
+{
+    img._image = NULL;
+}
+
+Image& Image::operator=(Image &&img) noexcept
+{
+    std::swap(_image, img._image);
+
+    return *this;
+}
+
+Image::Image(ImageData *image)
+    : _image(image)
+{
 }
 
 
@@ -122,17 +147,17 @@ int Image::get_image_type() const
 
 Image Image::get_area(const Rectangle &roi) const
 {
-    Image img_copy(*this);
-    *(img_copy._image) = _image->get_area(roi);
+    return Image(new ImageData(_image->get_area(roi)));
+}
 
-    return img_copy;
+PatchIterator Image::get_patches(cv::Size size, cv::Size stride) const
+{
+    return _image->get_patches(size, stride);
 }
 
 cv::Mat Image::get_cvmat() const
 {
-    cv::Mat mat = _image->get_cvmat();
-
-    return mat.clone();
+    return _image->get_cvmat();
 }
 
 void Image::get_raw_data(void* buffer, int buffer_size ) const
@@ -164,6 +189,21 @@ void Image::set_compression(CompressionType comp)
     _image->set_compression(comp);
 }
 
+void Image::set_pyramid_levels(int levels)
+{
+    _image->set_pyramid_levels(levels);
+}
+
+void Image::set_tiling(TilingPolicy policy, int size)
+{
+    _image->set_tiling(policy, size);
+}
+
+void Image::set_sequential_read(bool sequential)
+{
+    _image->set_sequential_read(sequential);
+}
+
 void Image::set_dimensions(cv::Size dims)
 {
     _image->set_dimensions(dims);
@@ -179,6 +219,11 @@ void Image::set_minimum_dimension(int dimension)
     _image->set_minimum(dimension);
 }
 
+void Image::set_num_threads(int threads)
+{
+    _image->set_num_threads(threads);
+}
+
     /*  *********************** */
     /*    IMAGE INTERACTIONS    */
     /*  *********************** */
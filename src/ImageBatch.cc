@@ -0,0 +1,200 @@
+/**
+ * @file   ImageBatch.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <chrono>
+#include <set>
+#include <utility>
+
+#include <omp.h>
+
+#include "ImageBatch.h"
+#include "TDBImage.h"
+#include "Exception.h"
+
+using namespace VCL;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+
+ImageBatch::ImageBatch()
+{
+    _compress = CompressionType::LZ4;
+    _num_threads = 0;
+
+    _seconds = 0;
+    _bytes = 0;
+}
+
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+
+int ImageBatch::size() const
+{
+    return _entries.size();
+}
+
+const std::vector<ImageBatch::Status>& ImageBatch::get_status() const
+{
+    return _status;
+}
+
+int ImageBatch::get_num_stored() const
+{
+    int stored = 0;
+    for ( int i = 0; i < int(_status.size()); ++i ) {
+        if ( _status[i].stored )
+            ++stored;
+    }
+    return stored;
+}
+
+double ImageBatch::get_images_per_second() const
+{
+    if ( _seconds == 0 )
+        return 0;
+    return get_num_stored() / _seconds;
+}
+
+double ImageBatch::get_bytes_per_second() const
+{
+    if ( _seconds == 0 )
+        return 0;
+    return _bytes / _seconds;
+}
+
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+
+void ImageBatch::set_compression(CompressionType comp)
+{
+    _compress = comp;
+}
+
+void ImageBatch::set_num_threads(int threads)
+{
+    if ( threads < 0 )
+        throw VCLException(UnsupportedOperation, "Number of threads cannot be negative");
+    _num_threads = threads;
+}
+
+
+    /*  *********************** */
+    /*   IMAGEBATCH INTERACTION */
+    /*  *********************** */
+
+void ImageBatch::add(const std::string &source_id, const std::string &image_id)
+{
+    Entry entry = { source_id, NULL, image_id };
+    _entries.push_back(entry);
+}
+
+void ImageBatch::add(Image image, const std::string &image_id)
+{
+    Entry entry = { "", std::make_shared<Image>(std::move(image)), image_id };
+    _entries.push_back(entry);
+}
+
+void ImageBatch::store(ImageFormat image_format, bool store_metadata)
+{
+    typedef std::chrono::steady_clock Clock;
+
+    int count = _entries.size();
+    _status.assign(count, Status());
+
+    // Creating the same TileDB group from two threads fails, so create
+    // every workspace and group once before the workers start
+    if ( image_format == TDB ) {
+        std::set<std::string> groups;
+        for ( int i = 0; i < count; ++i ) {
+            std::string image_id = _entries[i].image_id;
+            std::string group = image_id.substr(0, image_id.rfind("/") + 1);
+
+            if ( groups.insert(group).second ) {
+                try {
+                    TDBImage tdb(image_id);
+                }
+                catch ( VCL::Exception &e ) {
+                    // Reported by the images in that group
+                }
+            }
+        }
+    }
+
+    int num_threads = _num_threads > 0 ? _num_threads : omp_get_max_threads();
+
+    Clock::time_point start = Clock::now();
+    size_t bytes = 0;
+
+    // Dynamic scheduling hands out one image at a time, so each worker
+    // holds a single decoded image
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) reduction(+:bytes)
+    for ( int i = 0; i < count; ++i ) {
+        Entry &entry = _entries[i];
+        Status &status = _status[i];
+
+        status.image_id = entry.image_id;
+        status.stored = false;
+        status.bytes = 0;
+
+        Clock::time_point image_start = Clock::now();
+
+        try {
+            std::shared_ptr<Image> image = std::move(entry.image);
+            if ( image == NULL ) {
+                image = std::make_shared<Image>(entry.source_id);
+                image->set_sequential_read(true);
+            }
+
+            image->set_compression(_compress);
+            image->store(entry.image_id, image_format, store_metadata);
+
+            status.bytes = image->get_raw_data_size();
+            status.stored = true;
+            bytes += status.bytes;
+        }
+        catch ( VCL::Exception &e ) {
+            status.error = e.msg.empty() ? e.name : e.msg;
+        }
+        catch ( std::exception &e ) {
+            status.error = e.what();
+        }
+
+        status.seconds = std::chrono::duration<double>(Clock::now() - image_start).count();
+    }
+
+    _seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    _bytes = bytes;
+
+    _entries.clear();
+}
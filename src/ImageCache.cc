@@ -0,0 +1,194 @@
+/**
+ * @file   ImageCache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the C++ API for ImageCache
+ */
+
+#include "ImageCache.h"
+
+using namespace VCL;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+
+ImageCache::ImageCache()
+{
+    _capacity = 0;
+    _size = 0;
+
+    _hits = 0;
+    _misses = 0;
+    _evictions = 0;
+}
+
+ImageCache& ImageCache::instance()
+{
+    static ImageCache cache;
+    return cache;
+}
+
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+
+size_t ImageCache::get_capacity()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _capacity;
+}
+
+size_t ImageCache::get_size()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _size;
+}
+
+int ImageCache::get_num_entries()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _entries.size();
+}
+
+uint64_t ImageCache::get_hits()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _hits;
+}
+
+uint64_t ImageCache::get_misses()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _misses;
+}
+
+uint64_t ImageCache::get_evictions()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _evictions;
+}
+
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+
+void ImageCache::set_capacity(size_t bytes)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    _capacity = bytes;
+    evict(_capacity);
+}
+
+void ImageCache::reset_counters()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    _hits = 0;
+    _misses = 0;
+    _evictions = 0;
+}
+
+
+    /*  *********************** */
+    /*    CACHE INTERACTION     */
+    /*  *********************** */
+
+bool ImageCache::get(const std::string &key, cv::Mat &image)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if ( _capacity == 0 )
+        return false;
+
+    auto found = _index.find(key);
+    if ( found == _index.end() ) {
+        ++_misses;
+        return false;
+    }
+
+    // Moving the entry to the front keeps the iterators valid
+    _entries.splice(_entries.begin(), _entries, found->second);
+    image = found->second->image;
+
+    ++_hits;
+    return true;
+}
+
+void ImageCache::put(const std::string &key, const cv::Mat &image)
+{
+    size_t size = image.total() * image.elemSize();
+
+    // An area shares the whole image it came from, so it is copied to
+    // keep only what is accounted for
+    cv::Mat cached = image;
+    if ( image.isSubmatrix() && size <= get_capacity() )
+        cached = image.clone();
+
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if ( size > _capacity || image.empty() )
+        return;
+
+    auto found = _index.find(key);
+    if ( found != _index.end() ) {
+        _size -= found->second->size;
+        _entries.erase(found->second);
+        _index.erase(found);
+    }
+
+    evict(_capacity - size);
+
+    Entry entry = { key, cached, size };
+    _entries.push_front(entry);
+    _index[key] = _entries.begin();
+    _size += size;
+}
+
+void ImageCache::clear()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    _entries.clear();
+    _index.clear();
+    _size = 0;
+}
+
+void ImageCache::evict(size_t capacity)
+{
+    while ( _size > capacity ) {
+        Entry &entry = _entries.back();
+        _size -= entry.size;
+        _index.erase(entry.key);
+        _entries.pop_back();
+        ++_evictions;
+    }
+}
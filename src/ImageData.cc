@@ -34,6 +34,10 @@
 #include <iostream>
 
 #include "ImageData.h"
+#include "ImageCache.h"
+#include "ImageHeader.h"
+#include "MappedFile.h"
+#include "PatchIterator.h"
 #include "TDBImage.h"
 #include "VCL.h"
 
@@ -42,13 +46,21 @@ using namespace VCL;
     /*  *********************** */
     /*        OPERATION         */
     /*  *********************** */
+static std::string rect_key(const Rectangle &rect)
+{
+    return std::to_string(rect.x) + "," + std::to_string(rect.y) + ","
+        + std::to_string(rect.width) + "," + std::to_string(rect.height);
+}
 
     /*  *********************** */
     /*       READ OPERATION     */
     /*  *********************** */
-ImageData::Read::Read(const std::string& filename, ImageFormat format)
+ImageData::Read::Read(const std::string& filename, ImageFormat format,
+    const Rectangle &rect, const cv::Size &target)
     : Operation(format),
-      _fullpath(filename)
+      _fullpath(filename),
+      _rect(rect),
+      _target(target)
 {
 }
 
@@ -59,19 +71,125 @@ void ImageData::Read::operator()(ImageData *img)
             throw VCLException(TileDBNotFound, "ImageFormat indicates image \
                 stored in TDB format, but no data was found");
 
-        img->_tdb->read();
+        if ( _rect.area() == 0 )
+            img->_tdb->read();
+        else
+            img->_tdb->crop(_rect);
         img->_height = img->_tdb->get_image_height();
         img->_width = img->_tdb->get_image_width();
         img->_channels = img->_tdb->get_image_channels();
+        img->_cv_type = img->_tdb->get_image_type();
     }
     else {
-        img->copy_cv(cv::imread(_fullpath, cv::IMREAD_ANYCOLOR));
-        if ( img->_cv_img.empty() )
+        cv::Mat cv_img;
+        {
+            // Decoded straight from the page cache, unmapped once decoded
+            MappedFile file(_fullpath, img->_sequential_read);
+            cv_img = cv::imdecode(file.get_cvmat(), get_read_flags());
+        }
+        if ( cv_img.empty() )
             throw VCLException(ObjectEmpty, _fullpath + " could not be read, \
                 object is empty");
+
+        if ( _rect.area() != 0 ) {
+            if ( cv_img.rows < _rect.height + _rect.y || cv_img.cols < _rect.width + _rect.x )
+                throw VCLException(SizeMismatch, "Requested area is not within the image");
+            cv_img = cv::Mat(cv_img, _rect);
+        }
+
+        img->share_cv(cv_img);
+    }
+}
+
+int ImageData::Read::get_scale(const cv::Size &dims) const
+{
+    if ( _format != VCL::JPG || _rect.area() != 0 || _target.area() == 0 )
+        return 1;
+
+    // The reduced size is rounded up, the resize that follows makes it exact
+    int scale = 1;
+    while ( scale < 8
+        && (dims.width + 2 * scale - 1) / (2 * scale) >= _target.width
+        && (dims.height + 2 * scale - 1) / (2 * scale) >= _target.height )
+        scale *= 2;
+
+    return scale;
+}
+
+int ImageData::Read::get_read_flags() const
+{
+    if ( _format != VCL::JPG || _rect.area() != 0 || _target.area() == 0 )
+        return cv::IMREAD_ANYCOLOR;
+
+    cv::Size dims;
+    int channels;
+    if ( !read_jpeg_header(_fullpath, dims, channels) )
+        return cv::IMREAD_ANYCOLOR;
+
+    switch ( get_scale(dims) ) {
+        case 2:
+            return channels == 1 ? cv::IMREAD_REDUCED_GRAYSCALE_2
+                : cv::IMREAD_REDUCED_COLOR_2;
+        case 4:
+            return channels == 1 ? cv::IMREAD_REDUCED_GRAYSCALE_4
+                : cv::IMREAD_REDUCED_COLOR_4;
+        case 8:
+            return channels == 1 ? cv::IMREAD_REDUCED_GRAYSCALE_8
+                : cv::IMREAD_REDUCED_COLOR_8;
+        default:
+            return cv::IMREAD_ANYCOLOR;
     }
 }
 
+bool ImageData::Read::infer_shape(ImageData *img, cv::Size &dims, int &cv_type)
+{
+    // Encoded images are sized from their headers, without decoding
+    if ( _format != VCL::TDB ) {
+        cv::Size full;
+        int channels;
+
+        bool known;
+        if ( _format == VCL::JPG )
+            known = read_jpeg_header(_fullpath, full, channels);
+        else if ( _format == VCL::PNG )
+            known = read_png_header(_fullpath, full, channels);
+        else
+            known = false;
+
+        if ( !known )
+            return false;
+
+        int scale = get_scale(full);
+        if ( _rect.area() != 0 )
+            dims = _rect.size();
+        else
+            dims = cv::Size((full.width + scale - 1) / scale,
+                (full.height + scale - 1) / scale);
+
+        // IMREAD_ANYCOLOR always converts to 8 bits
+        cv_type = CV_8UC(channels);
+        return true;
+    }
+
+    if ( img->_tdb == NULL )
+        throw VCLException(TileDBNotFound, "ImageFormat indicates image \
+            stored in TDB format, but no data was found");
+
+    if ( _rect.area() == 0 )
+        dims = cv::Size(img->_tdb->get_image_width(), img->_tdb->get_image_height());
+    else
+        dims = _rect.size();
+
+    cv_type = img->_tdb->get_image_type();
+    return true;
+}
+
+std::string ImageData::Read::get_key()
+{
+    return "read(" + rect_key(_rect) + "," + std::to_string(_target.width)
+        + "," + std::to_string(_target.height) + ")";
+}
+
     /*  *********************** */
     /*       WRITE OPERATION    */
     /*  *********************** */
@@ -91,6 +209,8 @@ void ImageData::Write::operator()(ImageData *img)
             img->_tdb = new TDBImage(_fullpath);
             img->_tdb->set_compression(img->_compress);
         }
+        img->_tdb->set_pyramid_levels(img->_pyramid_levels);
+        img->_tdb->set_tiling(img->_tiling, img->_tiling_size);
 
         if ( img->_tdb->has_data() )
             img->_tdb->write(_fullpath, _metadata);
@@ -112,6 +232,16 @@ void ImageData::Write::operator()(ImageData *img)
     }
 }
 
+bool ImageData::Write::infer_shape(ImageData *img, cv::Size &dims, int &cv_type)
+{
+    return true;
+}
+
+std::string ImageData::Write::get_key()
+{
+    return "write(" + _fullpath + ")";
+}
+
     /*  *********************** */
     /*       RESIZE OPERATION   */
     /*  *********************** */
@@ -119,22 +249,42 @@ void ImageData::Write::operator()(ImageData *img)
 void ImageData::Resize::operator()(ImageData *img)
 {
     if ( _format == VCL::TDB ) {
-        img->_tdb->resize(_rect);
+        if ( _area.area() == 0 )
+            img->_tdb->resize(_rect);
+        else
+            img->_tdb->resize(_rect, _area);
         img->_height = img->_tdb->get_image_height();
         img->_width = img->_tdb->get_image_width();
         img->_channels = img->_tdb->get_image_channels();
+        img->_cv_type = img->_tdb->get_image_type();
     }
     else {
         if ( !img->_cv_img.empty() ) {
             cv::Mat cv_resized;
             cv::resize(img->_cv_img, cv_resized, cv::Size(_rect.width, _rect.height));
-            img->copy_cv(cv_resized);
+            if ( _area.area() != 0 )
+                cv_resized = cv::Mat(cv_resized, _area);
+            img->share_cv(cv_resized);
         }
         else
             throw VCLException(ObjectEmpty, "Image object is empty");
     }
 }
 
+bool ImageData::Resize::infer_shape(ImageData *img, cv::Size &dims, int &cv_type)
+{
+    if ( _area.area() == 0 )
+        dims = _rect.size();
+    else
+        dims = _area.size();
+    return true;
+}
+
+std::string ImageData::Resize::get_key()
+{
+    return "resize(" + rect_key(_rect) + "," + rect_key(_area) + ")";
+}
+
     /*  *********************** */
     /*       CROP OPERATION     */
     /*  *********************** */
@@ -142,23 +292,36 @@ void ImageData::Resize::operator()(ImageData *img)
 void ImageData::Crop::operator()(ImageData *img)
 {
     if ( _format == VCL::TDB ) {
-        img->_tdb->read(_rect);
+        img->_tdb->crop(_rect);
         img->_height = img->_tdb->get_image_height();
         img->_width = img->_tdb->get_image_width();
         img->_channels = img->_tdb->get_image_channels();
+        img->_cv_type = img->_tdb->get_image_type();
     }
     else {
         if ( !img->_cv_img.empty() ) {
             if ( img->_cv_img.rows < _rect.height + _rect.y || img->_cv_img.cols < _rect.width + _rect.x )
                 throw VCLException(SizeMismatch, "Requested area is not within the image");
+            // No copy, operations never modify the data in place
             cv::Mat roi_img(img->_cv_img, _rect);
-            img->copy_cv(roi_img);
+            img->share_cv(roi_img);
         }
         else
             throw VCLException(ObjectEmpty, "Image object is empty");
     }
 }
 
+bool ImageData::Crop::infer_shape(ImageData *img, cv::Size &dims, int &cv_type)
+{
+    dims = _rect.size();
+    return true;
+}
+
+std::string ImageData::Crop::get_key()
+{
+    return "crop(" + rect_key(_rect) + ")";
+}
+
     /*  *********************** */
     /*    THRESHOLD OPERATION   */
     /*  *********************** */
@@ -168,14 +331,28 @@ void ImageData::Threshold::operator()(ImageData *img)
     if ( _format == VCL::TDB )
         img->_tdb->threshold(_threshold);
     else {
-        if ( !img->_cv_img.empty() )
-            cv::threshold(img->_cv_img, img->_cv_img, _threshold, _threshold,
+        if ( !img->_cv_img.empty() ) {
+            // The data may be shared with a Mat returned by get_cvmat
+            cv::Mat cv_thresholded;
+            cv::threshold(img->_cv_img, cv_thresholded, _threshold, _threshold,
                 cv::THRESH_TOZERO);
+            img->_cv_img = cv_thresholded;
+        }
         else
             throw VCLException(ObjectEmpty, "Image object is empty");
     }
 }
 
+bool ImageData::Threshold::infer_shape(ImageData *img, cv::Size &dims, int &cv_type)
+{
+    return true;
+}
+
+std::string ImageData::Threshold::get_key()
+{
+    return "threshold(" + std::to_string(_threshold) + ")";
+}
+
 
                     /*  *********************** */
                     /*         IMAGEDATA        */
@@ -194,6 +371,10 @@ ImageData::ImageData()
 
     _format = VCL::NONE;
     _compress = VCL::CompressionType::LZ4;
+    _pyramid_levels = 0;
+    _tiling = TilingPolicy::FACTOR;
+    _tiling_size = 0;
+    _sequential_read = false;
 
     _tdb = NULL;
     _image_id = "";
@@ -205,6 +386,10 @@ ImageData::ImageData(const cv::Mat &cv_img)
 
     _format = VCL::NONE;
     _compress = VCL::CompressionType::LZ4;
+    _pyramid_levels = 0;
+    _tiling = TilingPolicy::FACTOR;
+    _tiling_size = 0;
+    _sequential_read = false;
     _image_id = "";
 
     _tdb = NULL;
@@ -221,6 +406,10 @@ ImageData::ImageData(const std::string &image_id)
     set_format(extension);
 
     _compress = VCL::CompressionType::LZ4;
+    _pyramid_levels = 0;
+    _tiling = TilingPolicy::FACTOR;
+    _tiling_size = 0;
+    _sequential_read = false;
 
     _image_id = create_fullpath(image_id, _format);
 
@@ -242,39 +431,46 @@ ImageData::ImageData(void* buffer, cv::Size dimensions, int cv_type)
 
     _format = VCL::TDB;
     _compress = VCL::CompressionType::LZ4;
+    _pyramid_levels = 0;
+    _tiling = TilingPolicy::FACTOR;
+    _tiling_size = 0;
+    _sequential_read = false;
     _image_id = "";
 
     set_data_from_raw(buffer, _height*_width*_channels);
+    _tdb->set_image_properties(_height, _width, _channels);
     _tdb->set_compression(_compress);
 }
 
 ImageData::ImageData(const ImageData &img)
 {
+    _channels = img._channels;
+    _height = img._height;
+    _width = img._width;
+    _cv_type = img._cv_type;
+
     _format = img._format;
     _compress = img._compress;
+    _pyramid_levels = img._pyramid_levels;
+    _tiling = img._tiling;
+    _tiling_size = img._tiling_size;
+    _sequential_read = img._sequential_read;
     _image_id = img._image_id;
 
     if ( !(img._cv_img).empty() )
         copy_cv(img._cv_img);
 
-    if ( img._tdb != NULL )
-        _tdb = new TDBImage(*img._tdb);
+    // The TDB data is shared or read later, so a copy never reads more
+    // than the operations it is given need
+    if ( img._tdb != NULL ) {
+        _tdb = new TDBImage();
+        _tdb->share(*img._tdb);
+    }
     else
         _tdb = NULL;
 
-    int start;
-    if ( img._operations.size() > 0 ) {
-        std::shared_ptr<Operation> front = img._operations.front();
-        if (front->get_type() == OperationType::READ) {
-            start = 1;
-            copy_cv(cv::imread(img._image_id, cv::IMREAD_ANYCOLOR));
-        }
-        else
-            start = 0;
-
-        for (int i = start; i < img._operations.size(); ++i)
-            _operations.push_back(img._operations[i]);
-    }
+    // Operations are never modified once queued, so they can be shared
+    _operations = img._operations;
 }
 
 void ImageData::operator=(const ImageData &img)
@@ -294,33 +490,66 @@ void ImageData::operator=(const ImageData &img)
 
     _format = img._format;
     _compress = img._compress;
+    _pyramid_levels = img._pyramid_levels;
+    _tiling = img._tiling;
+    _tiling_size = img._tiling_size;
+    _sequential_read = img._sequential_read;
     _image_id = img._image_id;
 
     if ( img._tdb != NULL ) {
-        _tdb = new TDBImage(*img._tdb);
+        _tdb = new TDBImage();
+        _tdb->share(*img._tdb);
     }
     else
         _tdb = NULL;
 
-    int start;
+    _operations = img._operations;
 
-    _operations.clear();
-    _operations.shrink_to_fit();
+    delete temp;
+}
 
-    if ( img._operations.size() > 0 ) {
-        std::shared_ptr<Operation> front = img._operations.front();
-        if (front->get_type() == OperationType::READ) {
-            start = 1;
-            copy_cv(cv::imread(img._image_id, cv::IMREAD_ANYCOLOR));
-        }
-        else
-            start = 0;
+ImageData::ImageData(ImageData &&img) noexcept
+    : _height(img._height),
+      _width(img._width),
+      _cv_type(img._cv_type),
+      _channels(img._channels),
+      _operations(std::move(img._operations)),
+      _format(img._format),
+      _compress(img._compress),
+      _pyramid_levels(img._pyramid_levels),
+      _tiling(img._tiling),
+      _tiling_size(img._tiling_size),
+      _sequential_read(img._sequential_read),
+      _image_id(std::move(img._image_id)),
+      _cv_img(std::move(img._cv_img)),
+      _tdb(img._tdb)
+{
+    img._tdb = NULL;
+    img._cv_img.release();
+    img._operations.clear();
+}
 
-        for (int i = start; i < img._operations.size(); ++i)
-            _operations.push_back(img._operations[i]);
-    }
+ImageData& ImageData::operator=(ImageData &&img) noexcept
+{
+    _channels = img._channels;
+    _height = img._height;
+    _width = img._width;
+    _cv_type = img._cv_type;
 
-    delete temp;
+    _format = img._format;
+    _compress = img._compress;
+    _pyramid_levels = img._pyramid_levels;
+    _tiling = img._tiling;
+    _tiling_size = img._tiling_size;
+    _sequential_read = img._sequential_read;
+
+    // The previous data is released along with img
+    std::swap(_image_id, img._image_id);
+    std::swap(_operations, img._operations);
+    std::swap(_cv_img, img._cv_img);
+    std::swap(_tdb, img._tdb);
+
+    return *this;
 }
 
 ImageData::~ImageData()
@@ -345,37 +574,50 @@ ImageFormat ImageData::get_image_format() const
     return _format;
 }
 
-int ImageData::get_type() const
+int ImageData::get_type()
 {
-    return _cv_type;
+    cv::Size dims;
+    int cv_type;
+
+    if ( !infer_shape(dims, cv_type) ) {
+        perform_operations();
+        return _cv_type;
+    }
+
+    return cv_type;
 }
 
 cv::Size ImageData::get_dimensions()
 {
-    // TODO: iterate over operations themsevles to determine
-    //          image size, rather than performing the operations
-    if ( _operations.size() > 0 )
+    cv::Size dims;
+    int cv_type;
+
+    if ( !infer_shape(dims, cv_type) ) {
         perform_operations();
-    return cv::Size(_width, _height);
+        return cv::Size(_width, _height);
+    }
+
+    return dims;
 }
 
 int ImageData::get_size()
 {
-    if ( _height == 0 ) {
-        if ( _format == VCL::TDB ) {
-            if ( _tdb == NULL )
-                throw VCLException(TileDBNotFound, "ImageFormat indicates image \
-                    stored in TDB format, but no data was found");
-            return _tdb->get_image_size();
-        }
-        else {
-            std::shared_ptr<Operation> op = _operations.front();
-            (*op)(this);
-            _operations.erase(_operations.begin());
-        }
+    if ( _height == 0 && _operations.empty() && _format == VCL::TDB ) {
+        if ( _tdb == NULL )
+            throw VCLException(TileDBNotFound, "ImageFormat indicates image \
+                stored in TDB format, but no data was found");
+        return _tdb->get_image_size();
     }
 
-    return int(_height) * int(_width) * _channels;
+    cv::Size dims;
+    int cv_type;
+
+    if ( !infer_shape(dims, cv_type) ) {
+        perform_operations();
+        return int(_height) * int(_width) * _channels;
+    }
+
+    return dims.area() * CV_MAT_CN(cv_type);
 }
 
 void ImageData::get_buffer(void* buffer, int buffer_size)
@@ -447,13 +689,6 @@ ImageData ImageData::get_area(const Rectangle &roi)
 {
     ImageData area = *this;
 
-    if ( area._format == VCL::TDB && area._operations.size() == 1 ) {
-        if ( area._tdb == NULL )
-            throw VCLException(TileDBNotFound, "ImageFormat indicates image \
-                stored in TDB format, but no data was found");
-        area._operations.pop_back();
-    }
-
     std::shared_ptr<Operation> op = std::make_shared<Crop> (roi, area._format);
 
     area._operations.push_back(op);
@@ -466,6 +701,19 @@ ImageData ImageData::get_area(const Rectangle &roi)
     return area;
 }
 
+PatchIterator ImageData::get_patches(cv::Size size, cv::Size stride)
+{
+    if ( _format == VCL::TDB && _operations.size() == 1
+            && _operations[0]->get_type() == READ ) {
+        if ( _tdb == NULL )
+            throw VCLException(TileDBNotFound, "ImageFormat indicates image \
+                stored in TDB format, but no data was found");
+        return PatchIterator(_image_id, size, stride, _tdb->get_num_threads());
+    }
+
+    return PatchIterator(get_cvmat(), size, stride);
+}
+
 std::vector<unsigned char> ImageData::get_encoded(ImageFormat format,
     const std::vector<int>& params)
 {
@@ -544,6 +792,31 @@ void ImageData::set_compression(CompressionType comp)
     _compress = comp;
 }
 
+void ImageData::set_pyramid_levels(int levels)
+{
+    if ( levels < 0 )
+        throw VCLException(UnsupportedOperation, "The number of pyramid \
+            levels cannot be negative");
+
+    _pyramid_levels = levels;
+}
+
+void ImageData::set_tiling(TilingPolicy policy, int size)
+{
+    if ( size < 0 )
+        throw VCLException(UnsupportedOperation, "Tiling size cannot be negative");
+    if ( policy == TilingPolicy::FIXED && size == 0 )
+        throw VCLException(UnsupportedOperation, "Fixed tiling needs a tile size");
+
+    _tiling = policy;
+    _tiling_size = size;
+}
+
+void ImageData::set_sequential_read(bool sequential)
+{
+    _sequential_read = sequential;
+}
+
 void ImageData::set_dimensions(cv::Size dimensions)
 {
     _height = dimensions.height;
@@ -603,6 +876,16 @@ void ImageData::set_minimum(int dimension)
     }
 }
 
+void ImageData::set_num_threads(int threads)
+{
+    if ( _format == VCL::TDB ) {
+        if ( _tdb == NULL )
+            throw VCLException(TileDBNotFound, "ImageFormat indicates image \
+                stored in TDB format, but no data was found\n");
+        _tdb->set_num_threads(threads);
+    }
+}
+
 
     /*  *********************** */
     /*   IMAGEDATA INTERACTION  */
@@ -610,6 +893,21 @@ void ImageData::set_minimum(int dimension)
 
 void ImageData::perform_operations()
 {
+    plan_operations();
+
+    // The cache keeps its own copy of each decoded image, since
+    // get_cvmat hands out the image data without copying it
+    ImageCache &cache = ImageCache::instance();
+    std::string key = get_cache_key();
+    if ( !key.empty() ) {
+        cv::Mat cached;
+        if ( cache.get(key, cached) ) {
+            share_cv(cached.clone());
+            _operations.clear();
+            return;
+        }
+    }
+
     for (int x = 0; x < _operations.size(); ++x) {
         std::shared_ptr<Operation> op = _operations[x];
         if ( op == NULL )
@@ -617,6 +915,10 @@ void ImageData::perform_operations()
         (*op)(this);
     }
 
+    if ( !key.empty()
+        && _cv_img.total() * _cv_img.elemSize() <= cache.get_capacity() )
+        cache.put(key, _cv_img.clone());
+
     _operations.clear();
 }
 
@@ -641,13 +943,6 @@ void ImageData::resize(int rows, int columns)
 
 void ImageData::crop(const Rectangle &rect)
 {
-    if ( _format == VCL::TDB && _operations.size() == 1 ) {
-        if ( _tdb == NULL )
-            throw VCLException(TileDBNotFound, "ImageFormat indicates image \
-                stored in TDB format, but no data was found");
-        _operations.pop_back();
-    }
-
     _operations.push_back(std::make_shared<Crop> (rect, _format));
 }
 
@@ -686,32 +981,25 @@ void ImageData::copy_cv(const cv::Mat &cv_img)
     _cv_img = cv_img.clone();
 }
 
-template <class T>
-void ImageData::copy_to_buffer(T* buffer)
+void ImageData::share_cv(const cv::Mat &cv_img)
 {
-    int index = 0;
+    _channels = cv_img.channels();
 
-    int rows = _height;
-    int columns = _width;
+    _height = cv_img.rows;
+    _width = cv_img.cols;
 
-    if ( _cv_img.isContinuous() ) {
-        columns *= rows;
-        rows = 1;
-    }
+    _cv_type = cv_img.type();
 
-    for ( int i = 0; i < rows; ++i ) {
-        for ( int j = 0; j < columns; ++j ) {
-            if ( _channels == 1 )
-                buffer[index] = T(_cv_img.at<unsigned char>(i, j));
-            else {
-                cv::Vec3b colors = _cv_img.at<cv::Vec3b>(i, j);
-                for ( int x = 0; x < _channels; ++x ) {
-                    buffer[index + x] = T(colors.val[x]);
-                }
-            }
-            index += _channels;
-        }
-    }
+    _cv_img = cv_img;
+}
+
+template <class T>
+void ImageData::copy_to_buffer(T* buffer)
+{
+    // Converts the values if T is not the type of the image
+    cv::Mat typed(_height, _width, CV_MAKETYPE(cv::DataType<T>::depth, _channels),
+        buffer);
+    _cv_img.convertTo(typed, typed.type());
 }
 
 template void ImageData::copy_to_buffer(unsigned char* buffer);
@@ -722,6 +1010,213 @@ template void ImageData::copy_to_buffer(int* buffer);
 template void ImageData::copy_to_buffer(float* buffer);
 template void ImageData::copy_to_buffer(double* buffer);
 
+    /*  *********************** */
+    /*    PLANNING FUNCTIONS    */
+    /*  *********************** */
+
+bool ImageData::infer_shape(cv::Size &dims, int &cv_type)
+{
+    dims = cv::Size(_width, _height);
+    cv_type = _cv_type;
+
+    for (int x = 0; x < int(_operations.size()); ++x) {
+        std::shared_ptr<Operation> op = _operations[x];
+        if ( op == NULL )
+            throw VCLException(ObjectEmpty, "Nothing to be done");
+        if ( !op->infer_shape(this, dims, cv_type) )
+            return false;
+    }
+
+    return true;
+}
+
+void ImageData::plan_operations()
+{
+    // Rewrite neighbouring operations until nothing changes
+    bool changed = true;
+    while ( changed ) {
+        changed = false;
+
+        for ( int x = 0; x + 1 < int(_operations.size()); ++x ) {
+            std::shared_ptr<Operation> first = _operations[x];
+            std::shared_ptr<Operation> second = _operations[x + 1];
+            if ( first == NULL || second == NULL
+                || first->get_format() != second->get_format() )
+                continue;
+
+            // Thresholding is per pixel, so crop first and threshold less
+            if ( first->get_type() == THRESHOLD && second->get_type() == CROP ) {
+                std::swap(_operations[x], _operations[x + 1]);
+                changed = true;
+                continue;
+            }
+
+            // A threshold set before a TDB read is applied to each strip
+            // as it is read, instead of in another pass over the image
+            if ( first->get_type() == READ && second->get_type() == THRESHOLD
+                && first->get_format() == VCL::TDB ) {
+                std::swap(_operations[x], _operations[x + 1]);
+                changed = true;
+                continue;
+            }
+
+            std::shared_ptr<Operation> fused = fuse_operations(first, second);
+            if ( fused != NULL ) {
+                _operations[x] = fused;
+                _operations.erase(_operations.begin() + x + 1);
+                changed = true;
+            }
+        }
+    }
+
+    // JPEG images that are resized right away are decoded at a reduced size
+    for ( int x = 0; x + 1 < int(_operations.size()); ++x ) {
+        std::shared_ptr<Operation> first = _operations[x];
+        std::shared_ptr<Operation> second = _operations[x + 1];
+        if ( first == NULL || second == NULL
+            || first->get_type() != READ || second->get_type() != RESIZE
+            || first->get_format() != VCL::JPG
+            || second->get_format() != VCL::JPG )
+            continue;
+
+        Read* read = static_cast<Read*>(first.get());
+        if ( read->get_rect().area() != 0 )
+            continue;
+
+        cv::Size target = static_cast<Resize*>(second.get())->get_rect().size();
+        _operations[x] = std::make_shared<Read> (read->get_fullpath(),
+            VCL::JPG, Rectangle(), target);
+    }
+
+    // Drop writes that a later write replaces before anything reads them
+    for ( int x = 0; x < int(_operations.size()); ++x ) {
+        if ( _operations[x] == NULL || _operations[x]->get_type() != WRITE )
+            continue;
+
+        std::string path = static_cast<Write*>(_operations[x].get())->get_fullpath();
+
+        for ( int y = x + 1; y < int(_operations.size()); ++y ) {
+            std::shared_ptr<Operation> op = _operations[y];
+            if ( op == NULL )
+                break;
+            if ( op->get_type() == READ
+                && static_cast<Read*>(op.get())->get_fullpath() == path )
+                break;
+            if ( op->get_type() == WRITE
+                && static_cast<Write*>(op.get())->get_fullpath() == path ) {
+                _operations.erase(_operations.begin() + x);
+                --x;
+                break;
+            }
+        }
+    }
+}
+
+std::shared_ptr<ImageData::Operation> ImageData::fuse_operations(
+    const std::shared_ptr<Operation> &first,
+    const std::shared_ptr<Operation> &second)
+{
+    ImageFormat format = first->get_format();
+
+    switch ( second->get_type() ) {
+        case CROP: {
+            Rectangle rect = static_cast<Crop*>(second.get())->get_rect();
+
+            Rectangle area;
+            if ( first->get_type() == READ )
+                area = static_cast<Read*>(first.get())->get_rect();
+            else if ( first->get_type() == CROP )
+                area = static_cast<Crop*>(first.get())->get_rect();
+            else if ( first->get_type() == RESIZE ) {
+                // Only the source pixels the area needs are read or resized
+                Resize* resize = static_cast<Resize*>(first.get());
+                Rectangle size = resize->get_rect();
+                area = resize->get_area();
+                if ( area.area() == 0 )
+                    area = Rectangle(0, 0, size.width, size.height);
+
+                if ( rect.x + rect.width > area.width
+                    || rect.y + rect.height > area.height )
+                    break;
+
+                Rectangle combined(area.x + rect.x, area.y + rect.y,
+                    rect.width, rect.height);
+                return std::make_shared<Resize> (size, format, combined);
+            }
+            else
+                break;
+
+            // Crops outside the previous area are left to throw when performed
+            if ( area.area() != 0 && (rect.x + rect.width > area.width
+                || rect.y + rect.height > area.height) )
+                break;
+
+            Rectangle combined(area.x + rect.x, area.y + rect.y,
+                rect.width, rect.height);
+
+            if ( first->get_type() == READ ) {
+                Read* read = static_cast<Read*>(first.get());
+                return std::make_shared<Read> (read->get_fullpath(), format, combined);
+            }
+            return std::make_shared<Crop> (combined, format);
+        }
+        case RESIZE: {
+            // Only the last size matters, unless the first one is cropped
+            if ( first->get_type() == RESIZE
+                && static_cast<Resize*>(first.get())->get_area().area() == 0 )
+                return second;
+
+            // A TDB resize reads the image itself, from the closest
+            // pyramid level when there is one
+            if ( first->get_type() == READ && format == VCL::TDB
+                && static_cast<Read*>(first.get())->get_rect().area() == 0 )
+                return second;
+            break;
+        }
+        case THRESHOLD: {
+            if ( first->get_type() == THRESHOLD ) {
+                int value = std::max(static_cast<Threshold*>(first.get())->get_threshold(),
+                    static_cast<Threshold*>(second.get())->get_threshold());
+                return std::make_shared<Threshold> (value, format);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    return NULL;
+}
+
+std::string ImageData::get_cache_key()
+{
+    if ( _format == VCL::TDB || _operations.empty()
+            || _operations[0]->get_type() != READ
+            || ImageCache::instance().get_capacity() == 0 )
+        return "";
+
+    std::string fullpath =
+        std::static_pointer_cast<Read>(_operations[0])->get_fullpath();
+
+    // A file that is rewritten gets a new key, the read fails if it
+    // does not exist
+    struct stat st;
+    if ( stat(fullpath.c_str(), &st) != 0 )
+        return "";
+
+    std::string key = fullpath + ":" + std::to_string(st.st_mtim.tv_sec)
+        + "." + std::to_string(st.st_mtim.tv_nsec) + ":"
+        + std::to_string(st.st_size);
+
+    for ( int x = 0; x < int(_operations.size()); ++x ) {
+        if ( _operations[x]->get_type() == WRITE )
+            return "";
+        key += ":" + _operations[x]->get_key();
+    }
+
+    return key;
+}
+
     /*  *********************** */
     /*      UTIL FUNCTIONS      */
     /*  *********************** */
@@ -84,7 +84,39 @@ namespace VCL {
              */
             virtual void operator()(ImageData *img) = 0;
 
+            /**
+             *  Implemented by the specific operation, updates the
+             *    dimensions and type the image will have once the
+             *    operation is performed, without touching the pixel data
+             *
+             *  @param img  A pointer to the current ImageData object
+             *  @param dims  The dimensions before the operation, updated
+             *    to the dimensions after it
+             *  @param cv_type  The OpenCV type before the operation,
+             *    updated to the type after it
+             *  @return False if the result cannot be known without
+             *    performing the operation
+             */
+            virtual bool infer_shape(ImageData *img, cv::Size &dims,
+                int &cv_type) = 0;
+
             virtual OperationType get_type() = 0;
+
+            /**
+             *  Implemented by the specific operation, describes the
+             *    operation and its parameters, so equal operations
+             *    have equal keys
+             *
+             *  @return The key of the operation
+             */
+            virtual std::string get_key() = 0;
+
+            /**
+             *  Gets the format the operation was requested for
+             *
+             *  @return The ImageFormat of the operation
+             */
+            ImageFormat get_format() const { return _format; };
         };
 
     /*  *********************** */
@@ -97,6 +129,29 @@ namespace VCL {
         private:
             /** The full path to the object to read */
             std::string _fullpath;
+            /** The area to read, empty to read the whole image */
+            Rectangle _rect;
+            /** The size of a resize that follows the read, if any */
+            cv::Size _target;
+
+            /**
+             *  Gets the factor the image is scaled down by when it is
+             *    decoded, the largest one that keeps it at least as large
+             *    as the target. JPEG images can be decoded at 1/2, 1/4 or
+             *    1/8 of their size
+             *
+             *  @param dims  The full size of the image
+             *  @return  The scale factor, 1 to decode at full size
+             */
+            int get_scale(const cv::Size &dims) const;
+
+            /**
+             *  Gets the cv::imread flags that decode the image at the
+             *    scale given by get_scale
+             *
+             *  @return  The flags to pass to cv::imread
+             */
+            int get_read_flags() const;
 
         public:
             /**
@@ -104,9 +159,15 @@ namespace VCL {
              *
              *  @param filename  The full path to read from
              *  @param format  The format to read the image from
+             *  @param rect  The area of the image to read. Defaults to
+             *    an empty Rectangle, which reads the whole image
+             *  @param target  The size the image is resized to after
+             *    the read. Defaults to an empty Size (no resize)
              *  @see Image.h for more details on ImageFormat
              */
-            Read(const std::string& filename, ImageFormat format);
+            Read(const std::string& filename, ImageFormat format,
+                const Rectangle &rect = Rectangle(),
+                const cv::Size &target = cv::Size());
 
             /**
              *  Reads an image from the file system (based on the format
@@ -117,7 +178,15 @@ namespace VCL {
             void operator()(ImageData *img);
 
 
+            bool infer_shape(ImageData *img, cv::Size &dims, int &cv_type);
+
             OperationType get_type() { return READ; };
+
+            std::string get_key();
+
+            const std::string& get_fullpath() const { return _fullpath; };
+            const Rectangle& get_rect() const { return _rect; };
+            const cv::Size& get_target() const { return _target; };
         };
 
     /*  *********************** */
@@ -155,7 +224,13 @@ namespace VCL {
              */
             void operator()(ImageData *img);
 
+            bool infer_shape(ImageData *img, cv::Size &dims, int &cv_type);
+
             OperationType get_type() { return WRITE; };
+
+            std::string get_key();
+
+            const std::string& get_fullpath() const { return _fullpath; };
         };
 
     /*  *********************** */
@@ -168,6 +243,8 @@ namespace VCL {
          private:
             /** Gives the height and width to resize the image to */
             Rectangle _rect;
+            /** The area of the resized image to keep, all of it if empty */
+            Rectangle _area;
 
         public:
             /**
@@ -175,11 +252,15 @@ namespace VCL {
              *
              *  @param rect  Contains height and width to resize to
              *  @param format  The current format of the image data
+             *  @param area  The area of the resized image to keep (a
+             *    crop that follows the resize), defaults to all of it
              *  @see Image.h for more details on ImageFormat and Rectangle
              */
-            Resize(const Rectangle &rect, ImageFormat format)
+            Resize(const Rectangle &rect, ImageFormat format,
+                const Rectangle &area = Rectangle())
                 : Operation(format),
-                  _rect(rect)
+                  _rect(rect),
+                  _area(area)
             {
             };
 
@@ -190,7 +271,15 @@ namespace VCL {
              */
             void operator()(ImageData *img);
 
+            bool infer_shape(ImageData *img, cv::Size &dims, int &cv_type);
+
             OperationType get_type() { return RESIZE; };
+
+            std::string get_key();
+
+            const Rectangle& get_rect() const { return _rect; };
+
+            const Rectangle& get_area() const { return _area; };
         };
 
     /*  *********************** */
@@ -226,7 +315,13 @@ namespace VCL {
              */
             void operator()(ImageData *img);
 
+            bool infer_shape(ImageData *img, cv::Size &dims, int &cv_type);
+
             OperationType get_type() { return CROP; };
+
+            std::string get_key();
+
+            const Rectangle& get_rect() const { return _rect; };
         };
 
     /*  *********************** */
@@ -262,7 +357,13 @@ namespace VCL {
              */
             void operator()(ImageData *img);
 
+            bool infer_shape(ImageData *img, cv::Size &dims, int &cv_type);
+
             OperationType get_type() { return THRESHOLD; };
+
+            std::string get_key();
+
+            int get_threshold() const { return _threshold; };
         };
 
 
@@ -283,6 +384,16 @@ namespace VCL {
         ImageFormat _format;
         CompressionType _compress;
 
+        // Number of downsampled levels stored with a TDB image
+        int _pyramid_levels;
+
+        // How the tiles of a TDB image are sized when it is written
+        TilingPolicy _tiling;
+        int _tiling_size;
+
+        // Whether encoded files are read once from start to end
+        bool _sequential_read;
+
         // Full path to image
         std::string _image_id;
 
@@ -340,6 +451,23 @@ namespace VCL {
          */
         void operator=(const ImageData &img);
 
+        /**
+         *  Creates an ImageData object by taking over the data and queued
+         *    operations of an existing ImageData object, without copying
+         *
+         *  @param img  The ImageData object to move from, left empty
+         */
+        ImageData(ImageData &&img) noexcept;
+
+        /**
+         *  Sets an ImageData object to the data and queued operations of
+         *    another ImageData object, without copying
+         *
+         *  @param img  The ImageData object to move from
+         *  @return The current ImageData object
+         */
+        ImageData& operator=(ImageData &&img) noexcept;
+
         ~ImageData();
 
 
@@ -362,15 +490,19 @@ namespace VCL {
         ImageFormat get_image_format() const;
 
         /**
-         *  Gets the OpenCV type of the image
+         *  Gets the OpenCV type of the image once the queued operations
+         *    are performed, without performing them when it can be
+         *    determined from the metadata
          *
          *  @return The OpenCV type (CV_8UC3, etc)
          *  @see OpenCV documentation on types for more details
          */
-        int get_type() const;
+        int get_type();
 
         /**
-         *  Gets the dimensions (height and width) of the image
+         *  Gets the dimensions (height and width) of the image once the
+         *    queued operations are performed, without performing them
+         *    when they can be determined from the metadata
          *
          *  @return The height and width of the image as an OpenCV Size object
          */
@@ -378,6 +510,8 @@ namespace VCL {
 
         /**
          *  Gets the size of the image in pixels (height * width * channels)
+         *    once the queued operations are performed, without performing
+         *    them when it can be determined from the metadata
          *
          *  @return The size of the image in pixels
          */
@@ -411,6 +545,17 @@ namespace VCL {
          */
         ImageData get_area(const Rectangle &roi);
 
+        /**
+         *  Gets an iterator over fixed size patches of the image. TDB
+         *    images with only the read pending are streamed from the
+         *    array, others are iterated after performing the operations
+         *
+         *  @param size  The size of the patches
+         *  @param stride  The distance between neighboring patches
+         *  @return A PatchIterator positioned at the first patch
+         */
+        PatchIterator get_patches(cv::Size size, cv::Size stride);
+
         /**
          *  Gets encoded image data in a buffer
          *
@@ -472,6 +617,33 @@ namespace VCL {
          */
         void set_compression(CompressionType comp);
 
+        /**
+         *  Sets the number of downsampled levels (1/2, 1/4, ...) stored
+         *    along with the image when it is written in TDB format
+         *
+         *  @param levels  The number of pyramid levels, 0 for none
+         */
+        void set_pyramid_levels(int levels);
+
+        /**
+         *  Sets how the tiles are sized when the image is written in
+         *    TDB format
+         *
+         *  @param policy  The TilingPolicy, FACTOR by default
+         *  @param size  The tile length for FIXED, or the length of the
+         *    regions expected to be read for REGION_READS
+         */
+        void set_tiling(TilingPolicy policy, int size = 0);
+
+        /**
+         *  Sets whether JPG and PNG files are read once from start to
+         *    end (as in batch jobs), which lets the kernel read ahead
+         *    more and drop the pages sooner
+         *
+         *  @param sequential  Whether to give the sequential hint
+         */
+        void set_sequential_read(bool sequential);
+
         /**
          *  Sets the height and width of the image
          *
@@ -499,12 +671,19 @@ namespace VCL {
 
         void set_minimum(int dimension);
 
+        /**
+         *  Sets the number of threads used when reading the TDB data
+         *
+         *  @param threads  The number of threads, 0 uses the OpenMP default
+         */
+        void set_num_threads(int threads);
+
     /*  *********************** */
     /*   IMAGEDATA INTERACTION  */
     /*  *********************** */
         /**
          *  Performs the set of operations that have been requested
-         *    on the ImageData
+         *    on the ImageData, after rewriting them with plan_operations
          */
         void perform_operations();
 
@@ -579,6 +758,15 @@ namespace VCL {
          */
         void copy_cv(const cv::Mat &cv_img);
 
+        /**
+         *  Sets the ImageData OpenCV Mat to an existing OpenCV Mat
+         *    without copying the data. Used for Mats produced by an
+         *    operation, which are not shared with the caller
+         *
+         *  @param cv_img  An existing OpenCV Mat
+         */
+        void share_cv(const cv::Mat &cv_img);
+
         /**
          *  Copies the ImageData OpenCV Mat into a buffer
          *
@@ -587,6 +775,51 @@ namespace VCL {
          */
         template <class T> void copy_to_buffer(T* buffer);
 
+    /*  *********************** */
+    /*    PLANNING FUNCTIONS    */
+    /*  *********************** */
+        /**
+         *  Determines the dimensions and type of the image after the
+         *    queued operations from the metadata and the operations
+         *
+         *  @param dims  Set to the height and width of the image
+         *  @param cv_type  Set to the OpenCV type of the image
+         *  @return False if an operation has to be performed to know
+         *    the result
+         */
+        bool infer_shape(cv::Size &dims, int &cv_type);
+
+        /**
+         *  Rewrites the list of operations before they are performed:
+         *    crops are moved ahead of thresholds and merged into the read
+         *    (or into the previous crop), consecutive resizes and
+         *    thresholds are merged, and writes that are replaced by a
+         *    later write to the same path are dropped
+         */
+        void plan_operations();
+
+        /**
+         *  Merges two consecutive operations into one when possible
+         *
+         *  @param first  The operation performed first
+         *  @param second  The operation performed next
+         *  @return The merged operation, or NULL if they cannot be merged
+         */
+        std::shared_ptr<Operation> fuse_operations(
+            const std::shared_ptr<Operation> &first,
+            const std::shared_ptr<Operation> &second);
+
+        /**
+         *  Gets the key the result of the planned operations is kept
+         *    under in the ImageCache: the path and modification time
+         *    of the file read, and the keys of the operations
+         *
+         *  @return The key, or an empty string if the result cannot be
+         *    cached (the cache is disabled, the image is in TDB format,
+         *    it is not read from a file, or it is written)
+         */
+        std::string get_cache_key();
+
     /*  *********************** */
     /*      UTIL FUNCTIONS      */
     /*  *********************** */
@@ -0,0 +1,205 @@
+/**
+ * @file   ImageHeader.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "ImageHeader.h"
+
+using namespace VCL;
+
+namespace {
+
+    /*  *********************** */
+    /*           EXIF           */
+    /*  *********************** */
+    unsigned int read_uint(const unsigned char* data, int bytes,
+        bool little_endian)
+    {
+        unsigned int value = 0;
+        for ( int i = 0; i < bytes; ++i ) {
+            int shift = little_endian ? 8 * i : 8 * (bytes - 1 - i);
+            value |= (unsigned int)data[i] << shift;
+        }
+        return value;
+    }
+
+    /**
+     *  Gets the orientation tag from the first IFD of an APP1 segment,
+     *    1 (no transformation) if the segment does not have one
+     */
+    int exif_orientation(const std::vector<unsigned char> &segment)
+    {
+        const unsigned char exif[] = { 'E', 'x', 'i', 'f', 0, 0 };
+        if ( segment.size() < 14 || std::memcmp(segment.data(), exif, 6) != 0 )
+            return 1;
+
+        const unsigned char* tiff = segment.data() + 6;
+        size_t length = segment.size() - 6;
+
+        bool little_endian = tiff[0] == 'I' && tiff[1] == 'I';
+        if ( !little_endian && !(tiff[0] == 'M' && tiff[1] == 'M') )
+            return 1;
+
+        size_t ifd = read_uint(tiff + 4, 4, little_endian);
+        if ( ifd + 2 > length )
+            return 1;
+
+        int entries = read_uint(tiff + ifd, 2, little_endian);
+        for ( int i = 0; i < entries; ++i ) {
+            size_t entry = ifd + 2 + 12 * i;
+            if ( entry + 12 > length )
+                break;
+            if ( read_uint(tiff + entry, 2, little_endian) == 0x0112 )
+                return read_uint(tiff + entry + 8, 2, little_endian);
+        }
+
+        return 1;
+    }
+}
+
+    /*  *********************** */
+    /*           JPEG           */
+    /*  *********************** */
+
+bool VCL::read_jpeg_header(const std::string &filename, cv::Size &dims,
+    int &channels)
+{
+    std::ifstream file(filename, std::ios::binary);
+
+    // Start of image
+    if ( file.get() != 0xFF || file.get() != 0xD8 )
+        return false;
+
+    int orientation = 1;
+
+    while ( file ) {
+        if ( file.get() != 0xFF )
+            return false;
+
+        // Markers can be padded with any number of 0xFF bytes
+        int marker;
+        do {
+            marker = file.get();
+        } while ( marker == 0xFF );
+
+        if ( marker == EOF || marker == 0xD9 || marker == 0xDA )
+            return false;
+
+        // Markers without a segment
+        if ( marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7) )
+            continue;
+
+        int high = file.get();
+        int low = file.get();
+        if ( low == EOF )
+            return false;
+        int length = (high << 8 | low) - 2;
+        if ( length < 0 )
+            return false;
+
+        // SOF0 to SOF15, except DHT, JPG and DAC which share the range
+        bool frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4
+            && marker != 0xC8 && marker != 0xCC;
+        bool app1 = marker == 0xE1 && orientation == 1;
+
+        if ( !frame && !app1 ) {
+            file.seekg(length, std::ios::cur);
+            continue;
+        }
+
+        std::vector<unsigned char> segment(length);
+        if ( !file.read(reinterpret_cast<char*>(segment.data()), length) )
+            return false;
+
+        if ( app1 ) {
+            orientation = exif_orientation(segment);
+            continue;
+        }
+
+        // precision, height, width, number of components
+        if ( length < 6 )
+            return false;
+        int height = segment[1] << 8 | segment[2];
+        int width = segment[3] << 8 | segment[4];
+        int components = segment[5];
+
+        // A height of 0 is defined later in the scan
+        if ( height == 0 || width == 0 )
+            return false;
+
+        // Orientations 5 to 8 turn the image by 90 degrees
+        if ( orientation >= 5 && orientation <= 8 )
+            std::swap(width, height);
+
+        dims = cv::Size(width, height);
+        channels = components == 1 ? 1 : 3;
+        return true;
+    }
+
+    return false;
+}
+
+
+    /*  *********************** */
+    /*           PNG            */
+    /*  *********************** */
+
+bool VCL::read_png_header(const std::string &filename, cv::Size &dims,
+    int &channels)
+{
+    std::ifstream file(filename, std::ios::binary);
+
+    // Signature, then the IHDR chunk (length, type, width, height,
+    // bit depth, color type)
+    unsigned char header[26];
+    if ( !file.read(reinterpret_cast<char*>(header), sizeof(header)) )
+        return false;
+
+    const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if ( std::memcmp(header, signature, 8) != 0
+        || std::memcmp(header + 12, "IHDR", 4) != 0 )
+        return false;
+
+    unsigned int width = read_uint(header + 16, 4, false);
+    unsigned int height = read_uint(header + 20, 4, false);
+    int color_type = header[25];
+
+    if ( width == 0 || height == 0 || width > INT_MAX || height > INT_MAX )
+        return false;
+
+    dims = cv::Size(width, height);
+
+    // Everything but plain grayscale (including alpha) is read as BGR
+    channels = color_type == 0 ? 1 : 3;
+    return true;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file   ImageHeader.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares functions that read the size of encoded images from
+ * their headers, without decoding them.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <opencv2/core.hpp>
+
+namespace VCL {
+
+    /*  *********************** */
+    /*           JPEG           */
+    /*  *********************** */
+    /**
+     *  Reads the size and number of channels of a JPEG image from its
+     *    frame header. The size follows the EXIF orientation, as the
+     *    image returned by cv::imread does
+     *
+     *  @param filename  The full path of the JPEG file
+     *  @param dims  Set to the width and height of the decoded image
+     *  @param channels  Set to the number of channels cv::imread
+     *    returns with IMREAD_ANYCOLOR
+     *  @return  False if the file is not a JPEG image with a readable
+     *    frame header
+     */
+    bool read_jpeg_header(const std::string &filename, cv::Size &dims,
+        int &channels);
+
+
+    /*  *********************** */
+    /*           PNG            */
+    /*  *********************** */
+    /**
+     *  Reads the size and number of channels of a PNG image from its
+     *    IHDR chunk
+     *
+     *  @param filename  The full path of the PNG file
+     *  @param dims  Set to the width and height of the image
+     *  @param channels  Set to the number of channels cv::imread
+     *    returns with IMREAD_ANYCOLOR
+     *  @return  False if the file is not a PNG image
+     */
+    bool read_png_header(const std::string &filename, cv::Size &dims,
+        int &channels);
+};
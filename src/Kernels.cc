@@ -0,0 +1,566 @@
+/**
+ * @file   Kernels.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "Kernels.h"
+#include "utils.h"
+
+using namespace VCL;
+
+namespace {
+
+    /*  *********************** */
+    /*          RESIZE          */
+    /*  *********************** */
+    // Interpolation weights are fixed point with this many fractional bits,
+    // so a horizontally interpolated value fits in 19 bits and a fully
+    // interpolated one in 30 bits
+    const int resize_bits = 11;
+    const int resize_scale = 1 << resize_bits;
+
+    /**
+     *  The two source pixels (clamped to the image) that an output pixel
+     *    is interpolated from, and the weight of the second one
+     */
+    struct ResizeTap {
+        int first;
+        int second;
+        int weight;
+    };
+
+    ResizeTap resize_tap(int index, float ratio, int src_length)
+    {
+        // Same mapping as TDBImage::resize has always used. The second
+        // pixel is computed in float as well, so just below an integer
+        // the two pixels can be two apart
+        float scale = (index + 0.5) * ratio - 0.5;
+
+        ResizeTap tap;
+        tap.first = std::max(int(floor(scale)), 0);
+        tap.second = std::min(int(floor(scale + 1)), src_length - 1);
+        tap.first = std::min(tap.first, src_length - 1);
+        tap.second = std::max(tap.second, 0);
+
+        if ( tap.first == tap.second )
+            tap.weight = 0;
+        else
+            tap.weight = int(floor((scale - tap.first) * resize_scale
+                / (tap.second - tap.first) + 0.5f));
+
+        return tap;
+    }
+
+    void resize_row(const unsigned char* src, const int* first,
+        const int* second, const int* weight, int* dst, int length)
+    {
+        for ( int i = 0; i < length; ++i ) {
+            int left = src[first[i]];
+            int right = src[second[i]];
+            dst[i] = (left << resize_bits) + (right - left) * weight[i];
+        }
+    }
+
+    void resize_column_scalar(const int* top, const int* bottom, int weight,
+        unsigned char* dst, int length)
+    {
+        const int delta = 1 << (2 * resize_bits - 1);
+
+        for ( int i = 0; i < length; ++i ) {
+            int value = (top[i] << resize_bits) + (bottom[i] - top[i]) * weight;
+            dst[i] = (unsigned char)((value + delta) >> (2 * resize_bits));
+        }
+    }
+
+    __attribute__((target("sse4.1")))
+    void resize_column_sse41(const int* top, const int* bottom, int weight,
+        unsigned char* dst, int length)
+    {
+        const __m128i w = _mm_set1_epi32(weight);
+        const __m128i delta = _mm_set1_epi32(1 << (2 * resize_bits - 1));
+
+        int i = 0;
+        for ( ; i + 16 <= length; i += 16 ) {
+            __m128i values[4];
+            for ( int k = 0; k < 4; ++k ) {
+                __m128i t = _mm_loadu_si128((const __m128i*)(top + i + 4 * k));
+                __m128i b = _mm_loadu_si128((const __m128i*)(bottom + i + 4 * k));
+                __m128i v = _mm_add_epi32(_mm_slli_epi32(t, resize_bits),
+                    _mm_mullo_epi32(_mm_sub_epi32(b, t), w));
+                values[k] = _mm_srai_epi32(_mm_add_epi32(v, delta),
+                    2 * resize_bits);
+            }
+
+            __m128i low = _mm_packs_epi32(values[0], values[1]);
+            __m128i high = _mm_packs_epi32(values[2], values[3]);
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(low, high));
+        }
+
+        resize_column_scalar(top + i, bottom + i, weight, dst + i, length - i);
+    }
+
+    __attribute__((target("avx2")))
+    void resize_column_avx2(const int* top, const int* bottom, int weight,
+        unsigned char* dst, int length)
+    {
+        const __m256i w = _mm256_set1_epi32(weight);
+        const __m256i delta = _mm256_set1_epi32(1 << (2 * resize_bits - 1));
+        // packs/packus work within 128 bit lanes, this restores the order
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+        int i = 0;
+        for ( ; i + 32 <= length; i += 32 ) {
+            __m256i values[4];
+            for ( int k = 0; k < 4; ++k ) {
+                __m256i t = _mm256_loadu_si256((const __m256i*)(top + i + 8 * k));
+                __m256i b = _mm256_loadu_si256((const __m256i*)(bottom + i + 8 * k));
+                __m256i v = _mm256_add_epi32(_mm256_slli_epi32(t, resize_bits),
+                    _mm256_mullo_epi32(_mm256_sub_epi32(b, t), w));
+                values[k] = _mm256_srai_epi32(_mm256_add_epi32(v, delta),
+                    2 * resize_bits);
+            }
+
+            __m256i low = _mm256_packs_epi32(values[0], values[1]);
+            __m256i high = _mm256_packs_epi32(values[2], values[3]);
+            __m256i packed = _mm256_packus_epi16(low, high);
+            _mm256_storeu_si256((__m256i*)(dst + i),
+                _mm256_permutevar8x32_epi32(packed, order));
+        }
+
+        resize_column_scalar(top + i, bottom + i, weight, dst + i, length - i);
+    }
+
+    typedef void (*resize_column_fn)(const int*, const int*, int,
+        unsigned char*, int);
+
+    resize_column_fn select_resize_column()
+    {
+        if ( supports_avx2() )
+            return resize_column_avx2;
+        if ( supports_sse41() )
+            return resize_column_sse41;
+        return resize_column_scalar;
+    }
+
+    const resize_column_fn resize_column = select_resize_column();
+
+
+    /*  *********************** */
+    /*         CHANNELS         */
+    /*  *********************** */
+    /**
+     *  Byte shuffle masks that move 16 pixels (three 16 byte vectors)
+     *    between interleaved and planar order. A mask entry of -128
+     *    zeroes the byte, so each output is the OR of three shuffles
+     */
+    struct ChannelMasks {
+        // split[c][v]: the bytes of source vector v that belong to channel c
+        signed char split[3][3][16];
+        // merge[v][c]: the bytes of channel c that go to output vector v
+        signed char merge[3][3][16];
+
+        ChannelMasks()
+        {
+            for ( int c = 0; c < 3; ++c ) {
+                for ( int v = 0; v < 3; ++v ) {
+                    for ( int i = 0; i < 16; ++i ) {
+                        int byte = 3 * i + c - 16 * v;
+                        split[c][v][i] = (byte >= 0 && byte < 16) ? byte : -128;
+
+                        int pixel = 16 * v + i;
+                        merge[v][c][i] = (pixel % 3 == c) ? pixel / 3 : -128;
+                    }
+                }
+            }
+        }
+    };
+
+    const ChannelMasks channel_masks;
+
+    void split_channels_scalar(const unsigned char* src, unsigned char* blue,
+        unsigned char* green, unsigned char* red, size_t pixels)
+    {
+        for ( size_t i = 0; i < pixels; ++i ) {
+            blue[i] = src[3 * i];
+            green[i] = src[3 * i + 1];
+            red[i] = src[3 * i + 2];
+        }
+    }
+
+    void merge_channels_scalar(const unsigned char* blue,
+        const unsigned char* green, const unsigned char* red,
+        unsigned char* dst, size_t pixels)
+    {
+        for ( size_t i = 0; i < pixels; ++i ) {
+            dst[3 * i] = blue[i];
+            dst[3 * i + 1] = green[i];
+            dst[3 * i + 2] = red[i];
+        }
+    }
+
+    __attribute__((target("ssse3")))
+    void split_channels_ssse3(const unsigned char* src, unsigned char* blue,
+        unsigned char* green, unsigned char* red, size_t pixels)
+    {
+        __m128i masks[3][3];
+        for ( int c = 0; c < 3; ++c )
+            for ( int v = 0; v < 3; ++v )
+                masks[c][v] = _mm_loadu_si128(
+                    (const __m128i*)channel_masks.split[c][v]);
+
+        unsigned char* planes[] = { blue, green, red };
+
+        size_t i = 0;
+        for ( ; i + 16 <= pixels; i += 16 ) {
+            __m128i in[3];
+            for ( int v = 0; v < 3; ++v )
+                in[v] = _mm_loadu_si128((const __m128i*)(src + 3 * i + 16 * v));
+
+            for ( int c = 0; c < 3; ++c ) {
+                __m128i out = _mm_or_si128(
+                    _mm_or_si128(_mm_shuffle_epi8(in[0], masks[c][0]),
+                        _mm_shuffle_epi8(in[1], masks[c][1])),
+                    _mm_shuffle_epi8(in[2], masks[c][2]));
+                _mm_storeu_si128((__m128i*)(planes[c] + i), out);
+            }
+        }
+
+        split_channels_scalar(src + 3 * i, blue + i, green + i, red + i,
+            pixels - i);
+    }
+
+    __attribute__((target("ssse3")))
+    void merge_channels_ssse3(const unsigned char* blue,
+        const unsigned char* green, const unsigned char* red,
+        unsigned char* dst, size_t pixels)
+    {
+        __m128i masks[3][3];
+        for ( int v = 0; v < 3; ++v )
+            for ( int c = 0; c < 3; ++c )
+                masks[v][c] = _mm_loadu_si128(
+                    (const __m128i*)channel_masks.merge[v][c]);
+
+        const unsigned char* planes[] = { blue, green, red };
+
+        size_t i = 0;
+        for ( ; i + 16 <= pixels; i += 16 ) {
+            __m128i in[3];
+            for ( int c = 0; c < 3; ++c )
+                in[c] = _mm_loadu_si128((const __m128i*)(planes[c] + i));
+
+            for ( int v = 0; v < 3; ++v ) {
+                __m128i out = _mm_or_si128(
+                    _mm_or_si128(_mm_shuffle_epi8(in[0], masks[v][0]),
+                        _mm_shuffle_epi8(in[1], masks[v][1])),
+                    _mm_shuffle_epi8(in[2], masks[v][2]));
+                _mm_storeu_si128((__m128i*)(dst + 3 * i + 16 * v), out);
+            }
+        }
+
+        merge_channels_scalar(blue + i, green + i, red + i, dst + 3 * i,
+            pixels - i);
+    }
+
+    // The AVX2 versions run the SSSE3 shuffles on 32 pixels at a time,
+    // one group of 16 in each 128 bit lane, since vpshufb does not cross
+    // lanes. The planes are then contiguous, the interleaved side is
+    // loaded and stored one lane at a time
+    __attribute__((target("avx2")))
+    void split_channels_avx2(const unsigned char* src, unsigned char* blue,
+        unsigned char* green, unsigned char* red, size_t pixels)
+    {
+        __m256i masks[3][3];
+        for ( int c = 0; c < 3; ++c )
+            for ( int v = 0; v < 3; ++v )
+                masks[c][v] = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+                    (const __m128i*)channel_masks.split[c][v]));
+
+        unsigned char* planes[] = { blue, green, red };
+
+        size_t i = 0;
+        for ( ; i + 32 <= pixels; i += 32 ) {
+            __m256i in[3];
+            for ( int v = 0; v < 3; ++v ) {
+                const unsigned char* low = src + 3 * i + 16 * v;
+                in[v] = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)low)),
+                    _mm_loadu_si128((const __m128i*)(low + 48)), 1);
+            }
+
+            for ( int c = 0; c < 3; ++c ) {
+                __m256i out = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_shuffle_epi8(in[0], masks[c][0]),
+                        _mm256_shuffle_epi8(in[1], masks[c][1])),
+                    _mm256_shuffle_epi8(in[2], masks[c][2]));
+                _mm256_storeu_si256((__m256i*)(planes[c] + i), out);
+            }
+        }
+
+        split_channels_ssse3(src + 3 * i, blue + i, green + i, red + i,
+            pixels - i);
+    }
+
+    __attribute__((target("avx2")))
+    void merge_channels_avx2(const unsigned char* blue,
+        const unsigned char* green, const unsigned char* red,
+        unsigned char* dst, size_t pixels)
+    {
+        __m256i masks[3][3];
+        for ( int v = 0; v < 3; ++v )
+            for ( int c = 0; c < 3; ++c )
+                masks[v][c] = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+                    (const __m128i*)channel_masks.merge[v][c]));
+
+        const unsigned char* planes[] = { blue, green, red };
+
+        size_t i = 0;
+        for ( ; i + 32 <= pixels; i += 32 ) {
+            __m256i in[3];
+            for ( int c = 0; c < 3; ++c )
+                in[c] = _mm256_loadu_si256((const __m256i*)(planes[c] + i));
+
+            for ( int v = 0; v < 3; ++v ) {
+                __m256i out = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_shuffle_epi8(in[0], masks[v][0]),
+                        _mm256_shuffle_epi8(in[1], masks[v][1])),
+                    _mm256_shuffle_epi8(in[2], masks[v][2]));
+                unsigned char* low = dst + 3 * i + 16 * v;
+                _mm_storeu_si128((__m128i*)low, _mm256_castsi256_si128(out));
+                _mm_storeu_si128((__m128i*)(low + 48),
+                    _mm256_extracti128_si256(out, 1));
+            }
+        }
+
+        merge_channels_ssse3(blue + i, green + i, red + i, dst + 3 * i,
+            pixels - i);
+    }
+
+    typedef void (*split_channels_fn)(const unsigned char*, unsigned char*,
+        unsigned char*, unsigned char*, size_t);
+    typedef void (*merge_channels_fn)(const unsigned char*,
+        const unsigned char*, const unsigned char*, unsigned char*, size_t);
+
+    split_channels_fn select_split_channels()
+    {
+        if ( supports_avx2() )
+            return split_channels_avx2;
+        if ( supports_ssse3() )
+            return split_channels_ssse3;
+        return split_channels_scalar;
+    }
+
+    merge_channels_fn select_merge_channels()
+    {
+        if ( supports_avx2() )
+            return merge_channels_avx2;
+        if ( supports_ssse3() )
+            return merge_channels_ssse3;
+        return merge_channels_scalar;
+    }
+
+    const split_channels_fn split_channels_impl = select_split_channels();
+    const merge_channels_fn merge_channels_impl = select_merge_channels();
+
+    /*  *********************** */
+    /*         THRESHOLD        */
+    /*  *********************** */
+    // A value is kept when it is at least the threshold plus one, that
+    // is when its unsigned maximum with it is the value itself
+    void threshold_tozero_scalar(const unsigned char* src, unsigned char* dst,
+        size_t length, unsigned char keep)
+    {
+        for ( size_t i = 0; i < length; ++i )
+            dst[i] = src[i] >= keep ? src[i] : 0;
+    }
+
+    void threshold_tozero_sse2(const unsigned char* src, unsigned char* dst,
+        size_t length, unsigned char keep)
+    {
+        const __m128i k = _mm_set1_epi8(char(keep));
+
+        size_t i = 0;
+        for ( ; i + 16 <= length; i += 16 ) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i mask = _mm_cmpeq_epi8(_mm_max_epu8(v, k), v);
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_and_si128(v, mask));
+        }
+
+        threshold_tozero_scalar(src + i, dst + i, length - i, keep);
+    }
+
+    __attribute__((target("avx2")))
+    void threshold_tozero_avx2(const unsigned char* src, unsigned char* dst,
+        size_t length, unsigned char keep)
+    {
+        const __m256i k = _mm256_set1_epi8(char(keep));
+
+        size_t i = 0;
+        for ( ; i + 32 <= length; i += 32 ) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            __m256i mask = _mm256_cmpeq_epi8(_mm256_max_epu8(v, k), v);
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_and_si256(v, mask));
+        }
+
+        threshold_tozero_sse2(src + i, dst + i, length - i, keep);
+    }
+
+    typedef void (*threshold_tozero_fn)(const unsigned char*, unsigned char*,
+        size_t, unsigned char);
+
+    // SSE2 is part of x86-64, so there is no scalar only version
+    threshold_tozero_fn select_threshold_tozero()
+    {
+        if ( supports_avx2() )
+            return threshold_tozero_avx2;
+        return threshold_tozero_sse2;
+    }
+
+    const threshold_tozero_fn threshold_tozero_impl = select_threshold_tozero();
+}
+
+    /*  *********************** */
+    /*          RESIZE          */
+    /*  *********************** */
+
+cv::Rect VCL::resize_source_area(const cv::Rect &dst_area, cv::Size src_size,
+    cv::Size dst_size)
+{
+    float row_ratio = src_size.height / float(dst_size.height);
+    float column_ratio = src_size.width / float(dst_size.width);
+
+    ResizeTap top = resize_tap(dst_area.y, row_ratio, src_size.height);
+    ResizeTap bottom = resize_tap(dst_area.y + dst_area.height - 1,
+        row_ratio, src_size.height);
+    ResizeTap left = resize_tap(dst_area.x, column_ratio, src_size.width);
+    ResizeTap right = resize_tap(dst_area.x + dst_area.width - 1,
+        column_ratio, src_size.width);
+
+    return cv::Rect(left.first, top.first, right.second - left.first + 1,
+        bottom.second - top.first + 1);
+}
+
+void VCL::resize_bilinear(const unsigned char* src, size_t src_step,
+    const cv::Rect &src_area, cv::Size src_size,
+    unsigned char* dst, size_t dst_step,
+    const cv::Rect &dst_area, cv::Size dst_size, int channels)
+{
+    if ( dst_area.width <= 0 || dst_area.height <= 0 )
+        return;
+
+    float row_ratio = src_size.height / float(dst_size.height);
+    float column_ratio = src_size.width / float(dst_size.width);
+
+    int length = dst_area.width * channels;
+
+    // Offsets (into a source row) and weights of every output value
+    std::vector<int> first(length), second(length), weight(length);
+    for ( int c = 0; c < dst_area.width; ++c ) {
+        ResizeTap tap = resize_tap(dst_area.x + c, column_ratio, src_size.width);
+        for ( int x = 0; x < channels; ++x ) {
+            int i = c * channels + x;
+            first[i] = (tap.first - src_area.x) * channels + x;
+            second[i] = (tap.second - src_area.x) * channels + x;
+            weight[i] = tap.weight;
+        }
+    }
+
+    // Horizontally resized source rows, kept while the next output
+    // rows still need them
+    std::vector<int> rows(2 * length);
+    int* buffers[2] = { &rows[0], &rows[length] };
+    int cached[2] = { -1, -1 };
+
+    for ( int r = 0; r < dst_area.height; ++r ) {
+        ResizeTap tap = resize_tap(dst_area.y + r, row_ratio, src_size.height);
+        int needed[2] = { tap.first, tap.second };
+        int slots[2];
+
+        for ( int t = 0; t < 2; ++t ) {
+            if ( cached[0] == needed[t] )
+                slots[t] = 0;
+            else if ( cached[1] == needed[t] )
+                slots[t] = 1;
+            else {
+                // Do not overwrite the row the other tap uses
+                if ( t == 0 )
+                    slots[t] = cached[0] == needed[1] ? 1 : 0;
+                else
+                    slots[t] = 1 - slots[0];
+
+                const unsigned char* row = src
+                    + (needed[t] - src_area.y) * src_step;
+                resize_row(row, first.data(), second.data(), weight.data(),
+                    buffers[slots[t]], length);
+                cached[slots[t]] = needed[t];
+            }
+        }
+
+        resize_column(buffers[slots[0]], buffers[slots[1]], tap.weight,
+            dst + r * dst_step, length);
+    }
+}
+
+
+    /*  *********************** */
+    /*         CHANNELS         */
+    /*  *********************** */
+
+void VCL::split_channels(const unsigned char* src, unsigned char* blue,
+    unsigned char* green, unsigned char* red, size_t pixels)
+{
+    split_channels_impl(src, blue, green, red, pixels);
+}
+
+void VCL::merge_channels(const unsigned char* blue, const unsigned char* green,
+    const unsigned char* red, unsigned char* dst, size_t pixels)
+{
+    merge_channels_impl(blue, green, red, dst, pixels);
+}
+
+
+    /*  *********************** */
+    /*         THRESHOLD        */
+    /*  *********************** */
+
+void VCL::threshold_tozero(const unsigned char* src, unsigned char* dst,
+    size_t length, int value)
+{
+    if ( value < 0 ) {
+        if ( src != dst )
+            std::memmove(dst, src, length);
+    }
+    else if ( value >= 255 )
+        std::memset(dst, 0, length);
+    else
+        threshold_tozero_impl(src, dst, length, (unsigned char)(value + 1));
+}
@@ -0,0 +1,126 @@
+/**
+ * @file   Kernels.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares the pixel kernels used by TDBImage. Kernels operate on
+ * row-major 8-bit data and pick an SSE4.1/SSSE3 or AVX2 implementation at run
+ * time when the CPU supports it, falling back to scalar code otherwise.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <opencv2/core.hpp>
+
+namespace VCL {
+
+    /*  *********************** */
+    /*          RESIZE          */
+    /*  *********************** */
+    /**
+     *  Gets the area of the source image needed to compute the given area
+     *    of a bilinear resize
+     *
+     *  @param dst_area  The area of the resized image to compute
+     *  @param src_size  The size of the full source image
+     *  @param dst_size  The size of the full resized image
+     *  @return  The area of the source image that contributes to dst_area
+     */
+    cv::Rect resize_source_area(const cv::Rect &dst_area, cv::Size src_size,
+        cv::Size dst_size);
+
+    /**
+     *  Resizes 8-bit row-major pixel data using bilinear interpolation
+     *    (pixel centers are aligned, as in TDBImage::resize and OpenCV).
+     *    Computes only dst_area of the resized image, from a buffer that
+     *    holds (at least) resize_source_area(dst_area) of the source image.
+     *    Weights are 11-bit fixed point, so results are within 1 of the
+     *    exact double precision interpolation
+     *
+     *  @param src  Pointer to the first pixel of src_area
+     *  @param src_step  Bytes between source rows
+     *  @param src_area  The area of the source image held in src
+     *  @param src_size  The size of the full source image
+     *  @param dst  Pointer to the first pixel of dst_area
+     *  @param dst_step  Bytes between destination rows
+     *  @param dst_area  The area of the resized image to compute
+     *  @param dst_size  The size of the full resized image
+     *  @param channels  The number of interleaved channels
+     */
+    void resize_bilinear(const unsigned char* src, size_t src_step,
+        const cv::Rect &src_area, cv::Size src_size,
+        unsigned char* dst, size_t dst_step,
+        const cv::Rect &dst_area, cv::Size dst_size, int channels);
+
+
+    /*  *********************** */
+    /*         CHANNELS         */
+    /*  *********************** */
+    /**
+     *  Splits interleaved 3-channel pixels (as stored in an OpenCV Mat)
+     *    into one plane per channel (as stored in TileDB attributes)
+     *
+     *  @param src  The interleaved pixels, 3 * pixels bytes
+     *  @param blue  The first channel plane, pixels bytes
+     *  @param green  The second channel plane, pixels bytes
+     *  @param red  The third channel plane, pixels bytes
+     *  @param pixels  The number of pixels to convert
+     */
+    void split_channels(const unsigned char* src, unsigned char* blue,
+        unsigned char* green, unsigned char* red, size_t pixels);
+
+    /**
+     *  Merges one plane per channel into interleaved 3-channel pixels,
+     *    the inverse of split_channels
+     *
+     *  @param blue  The first channel plane, pixels bytes
+     *  @param green  The second channel plane, pixels bytes
+     *  @param red  The third channel plane, pixels bytes
+     *  @param dst  The interleaved pixels, 3 * pixels bytes
+     *  @param pixels  The number of pixels to convert
+     */
+    void merge_channels(const unsigned char* blue, const unsigned char* green,
+        const unsigned char* red, unsigned char* dst, size_t pixels);
+
+
+    /*  *********************** */
+    /*         THRESHOLD        */
+    /*  *********************** */
+    /**
+     *  Sets 8-bit values less than or equal to the threshold to zero and
+     *    keeps the others, as cv::threshold with THRESH_TOZERO does
+     *
+     *  @param src  The values to threshold
+     *  @param dst  The thresholded values, can be src
+     *  @param length  The number of values
+     *  @param value  The threshold
+     */
+    void threshold_tozero(const unsigned char* src, unsigned char* dst,
+        size_t length, int value);
+};
@@ -0,0 +1,88 @@
+/**
+ * @file   MappedFile.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.h"
+#include "Exception.h"
+
+using namespace VCL;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+
+MappedFile::MappedFile(const std::string &filename, bool sequential)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if ( fd == -1 )
+        throw VCLException(OpenFailed, filename + " could not be opened");
+
+    struct stat file_stat;
+    if ( fstat(fd, &file_stat) == -1 || file_stat.st_size == 0 ) {
+        close(fd);
+        throw VCLException(ObjectEmpty, filename + " could not be read, \
+            object is empty");
+    }
+
+    _size = file_stat.st_size;
+    _data = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+
+    if ( _data == MAP_FAILED )
+        throw VCLException(OpenFailed, filename + " could not be mapped");
+
+    if ( sequential )
+        madvise(_data, _size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(_data, _size);
+}
+
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+
+size_t MappedFile::get_size() const
+{
+    return _size;
+}
+
+cv::Mat MappedFile::get_cvmat() const
+{
+    return cv::Mat(1, int(_size), CV_8UC1, _data);
+}
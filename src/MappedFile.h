@@ -0,0 +1,92 @@
+/**
+ * @file   MappedFile.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file declares MappedFile, a read-only memory mapping of a file that
+ * encoded images are decoded from without copying them into a buffer.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+#include <opencv2/core.hpp>
+
+namespace VCL {
+
+    class MappedFile {
+
+    /*  *********************** */
+    /*        VARIABLES         */
+    /*  *********************** */
+    private:
+        // Start and length of the mapping
+        void* _data;
+        size_t _size;
+
+    public:
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+        /**
+         *  Maps a file into memory for reading. The mapping is removed
+         *    when the MappedFile is destroyed
+         *
+         *  @param filename  The full path of the file
+         *  @param sequential  Whether to advise the kernel that the file
+         *    is read once from start to end, so it reads ahead more and
+         *    drops the pages sooner. Defaults to false
+         */
+        MappedFile(const std::string &filename, bool sequential = false);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile& operator=(const MappedFile &) = delete;
+
+        ~MappedFile();
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+        /**
+         *  Gets the length of the file
+         *
+         *  @return The length of the file in bytes
+         */
+        size_t get_size() const;
+
+        /**
+         *  Gets an OpenCV Mat (a single row of bytes) that points to the
+         *    mapping, for cv::imdecode. No copy is made, so the Mat is
+         *    only valid while the MappedFile exists
+         *
+         *  @return An OpenCV Mat of type CV_8UC1
+         */
+        cv::Mat get_cvmat() const;
+    };
+};
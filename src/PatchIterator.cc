@@ -0,0 +1,252 @@
+/**
+ * @file   PatchIterator.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the C++ API for PatchIterator
+ */
+
+#include <algorithm>
+
+#include "PatchIterator.h"
+#include "TDBImage.h"
+
+using namespace VCL;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+
+PatchIterator::PatchIterator(const cv::Mat &image, cv::Size size,
+    cv::Size stride)
+{
+    if ( image.empty() )
+        throw VCLException(ObjectEmpty, "Image object is empty");
+
+    _image = image;
+    _dimensions = image.size();
+    _cv_type = image.type();
+
+    _num_threads = 0;
+    _tile_height = 0;
+    _prefetch_row = -1;
+
+    set_window(size, stride);
+    load_patch();
+}
+
+PatchIterator::PatchIterator(const std::string &image_id, cv::Size size,
+    cv::Size stride, int num_threads)
+{
+    TDBImage tdb(image_id);
+
+    _tdb_id = image_id;
+    _dimensions = cv::Size(tdb.get_image_width(), tdb.get_image_height());
+    _cv_type = tdb.get_image_type();
+
+    _num_threads = num_threads;
+    _tile_height = tdb.get_tile_height();
+    _prefetch_row = -1;
+
+    set_window(size, stride);
+    load_patch();
+}
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+
+int PatchIterator::get_num_patches() const
+{
+    if ( _patch_size.width > _dimensions.width
+        || _patch_size.height > _dimensions.height )
+        return 0;
+
+    int columns = (_dimensions.width - _patch_size.width) / _stride.width + 1;
+    int rows = (_dimensions.height - _patch_size.height) / _stride.height + 1;
+
+    return columns * rows;
+}
+
+Rectangle PatchIterator::get_area() const
+{
+    if ( end() )
+        throw VCLException(ObjectEmpty, "No patches left");
+
+    return _area;
+}
+
+cv::Mat PatchIterator::get_patch() const
+{
+    if ( end() )
+        throw VCLException(ObjectEmpty, "No patches left");
+
+    return _patch;
+}
+
+    /*  *********************** */
+    /*        ITERATION         */
+    /*  *********************** */
+
+bool PatchIterator::end() const
+{
+    return _area.y + _area.height > _dimensions.height;
+}
+
+void PatchIterator::next()
+{
+    if ( end() )
+        return;
+
+    _area.x += _stride.width;
+
+    if ( _area.x + _area.width > _dimensions.width ) {
+        _area.x = 0;
+        _area.y += _stride.height;
+    }
+
+    load_patch();
+}
+
+    /*  *********************** */
+    /*     PRIVATE FUNCTIONS    */
+    /*  *********************** */
+
+void PatchIterator::set_window(cv::Size size, cv::Size stride)
+{
+    if ( size.width <= 0 || size.height <= 0 )
+        throw VCLException(SizeMismatch, "Patches must have at least one pixel");
+
+    if ( stride.width <= 0 || stride.height <= 0 )
+        throw VCLException(SizeMismatch, "Stride must be positive");
+
+    _patch_size = size;
+    _stride = stride;
+
+    // Patches wider than the image leave nothing to iterate
+    _area = Rectangle(0, 0, size.width, size.height);
+    if ( size.width > _dimensions.width )
+        _area.y = _dimensions.height;
+}
+
+void PatchIterator::load_patch()
+{
+    _patch.release();
+
+    if ( end() )
+        return;
+
+    if ( !_image.empty() ) {
+        _patch = _image(_area);
+        return;
+    }
+
+    if ( _area.x == 0 )
+        load_tile_rows(_area.y);
+
+    int first = _area.y / _tile_height;
+    int last = (_area.y + _area.height - 1) / _tile_height;
+
+    // Patches within a row of tiles share its data, others are copied
+    // from each row of tiles they cover
+    if ( first == last ) {
+        Rectangle area = _area;
+        area.y -= first * _tile_height;
+        _patch = _tile_rows[first](area);
+        return;
+    }
+
+    _patch.create(_area.height, _area.width, _cv_type);
+
+    int row = _area.y;
+    for ( int i = first; i <= last; ++i ) {
+        int end_row = std::min((i + 1) * _tile_height, _area.y + _area.height);
+        Rectangle source(_area.x, row - i * _tile_height, _area.width, end_row - row);
+        Rectangle target(0, row - _area.y, _area.width, end_row - row);
+
+        cv::Mat patch_rows(_patch, target);
+        _tile_rows[i](source).copyTo(patch_rows);
+
+        row = end_row;
+    }
+}
+
+void PatchIterator::load_tile_rows(int row)
+{
+    int first = row / _tile_height;
+    int last = (row + _patch_size.height - 1) / _tile_height;
+
+    // Rows of patches only move down, so rows above are not needed again
+    _tile_rows.erase(_tile_rows.begin(), _tile_rows.lower_bound(first));
+
+    for ( int i = first; i <= last; ++i ) {
+        if ( _tile_rows.count(i) > 0 )
+            continue;
+
+        // A stride longer than the patches can skip the prefetched row
+        if ( _prefetch.valid() && _prefetch_row < i )
+            _prefetch.get();
+
+        if ( _prefetch.valid() && _prefetch_row == i )
+            _tile_rows[i] = _prefetch.get();
+        else {
+            int start = i * _tile_height;
+            Rectangle area(0, start, _dimensions.width,
+                std::min(_tile_height, _dimensions.height - start));
+            _tile_rows[i] = read_tile_row(_tdb_id, area, _num_threads);
+        }
+    }
+
+    // The first row of tiles the next row of patches needs and that is
+    // not loaded yet is read while the patches of this row are used
+    int next_row = row + _stride.height;
+    if ( _prefetch.valid() || next_row + _patch_size.height > _dimensions.height )
+        return;
+
+    int next_first = std::max(last + 1, next_row / _tile_height);
+    int next_last = (next_row + _patch_size.height - 1) / _tile_height;
+    if ( next_first > next_last )
+        return;
+
+    int start = next_first * _tile_height;
+    Rectangle area(0, start, _dimensions.width,
+        std::min(_tile_height, _dimensions.height - start));
+
+    _prefetch_row = next_first;
+    _prefetch = std::async(std::launch::async, &PatchIterator::read_tile_row,
+        _tdb_id, area, _num_threads);
+}
+
+cv::Mat PatchIterator::read_tile_row(const std::string &image_id,
+    Rectangle area, int num_threads)
+{
+    TDBImage tdb(image_id);
+    tdb.set_num_threads(num_threads);
+    tdb.read(area);
+
+    return tdb.get_cvmat();
+}
@@ -0,0 +1,160 @@
+/**
+ * @file   TDBContextPool.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <tiledb.h>
+
+#include "TDBContextPool.h"
+#include "Exception.h"
+
+using namespace VCL;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+
+TDBContextPool::TDBContextPool()
+{
+    _affinity = SHARED;
+    _lifetime = PROCESS;
+}
+
+TDBContextPool::~TDBContextPool()
+{
+    for ( int i = 0; i < int(_contexts.size()); ++i )
+        tiledb_ctx_finalize(_contexts[i].ctx);
+}
+
+TDBContextPool& TDBContextPool::instance()
+{
+    static TDBContextPool pool;
+    return pool;
+}
+
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+
+int TDBContextPool::get_num_contexts()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _contexts.size();
+}
+
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+
+void TDBContextPool::configure(Affinity affinity, Lifetime lifetime)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if ( affinity != _affinity ) {
+        for ( int i = 0; i < int(_contexts.size()); ++i )
+            _contexts[i].stale = true;
+    }
+
+    _affinity = affinity;
+    _lifetime = lifetime;
+
+    trim();
+}
+
+
+    /*  *********************** */
+    /*    POOL INTERACTION      */
+    /*  *********************** */
+
+TileDB_CTX* TDBContextPool::acquire()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    std::thread::id owner;
+    if ( _affinity == PER_THREAD )
+        owner = std::this_thread::get_id();
+
+    for ( int i = 0; i < int(_contexts.size()); ++i ) {
+        Context &context = _contexts[i];
+        if ( !context.stale && context.owner == owner ) {
+            ++context.users;
+            return context.ctx;
+        }
+    }
+
+    TileDB_CTX* ctx;
+    if ( tiledb_ctx_init(&ctx, NULL) == TILEDB_ERR )
+        throw VCLException(TileDBError, "TileDB context initialization failed");
+
+    Context context = { ctx, owner, 1, false };
+    _contexts.push_back(context);
+
+    return ctx;
+}
+
+void TDBContextPool::release(TileDB_CTX* ctx)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    for ( int i = 0; i < int(_contexts.size()); ++i ) {
+        if ( _contexts[i].ctx == ctx ) {
+            --_contexts[i].users;
+            break;
+        }
+    }
+
+    trim();
+}
+
+void TDBContextPool::clear()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    for ( int i = 0; i < int(_contexts.size()); ) {
+        if ( _contexts[i].users == 0 ) {
+            tiledb_ctx_finalize(_contexts[i].ctx);
+            _contexts.erase(_contexts.begin() + i);
+        }
+        else
+            ++i;
+    }
+}
+
+void TDBContextPool::trim()
+{
+    for ( int i = 0; i < int(_contexts.size()); ) {
+        Context &context = _contexts[i];
+        if ( context.users == 0 && (context.stale || _lifetime == REFCOUNTED) ) {
+            tiledb_ctx_finalize(context.ctx);
+            _contexts.erase(_contexts.begin() + i);
+        }
+        else
+            ++i;
+    }
+}
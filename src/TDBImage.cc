@@ -30,19 +30,91 @@
 #include <stddef.h>
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <utility>
+#include <exception>
+#include <atomic>
+#include <mutex>
 
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <omp.h>
+
+#include <opencv2/imgproc.hpp>
 
 #include <tiledb.h>
 #include "TDBImage.h"
 #include "TDBObject.h"
+#include "Kernels.h"
+#include "TDBMetadataCache.h"
+#include "TDBTileCache.h"
 #include "VCL.h"
 
 using namespace VCL;
 
+// Bytes of pixels converted to planes for each TileDB write
+static const size_t write_strip_size = size_t(16) << 20;
+
+// Rows of tiles read at once by streaming resizes, one per thread
+static const int resize_read_tile_rows = 4;
+
+// Position of each property in the properties metadata. The values past
+// the last property are reserved for new ones and written as 0
+enum Property { HEIGHT, WIDTH, CHANNELS, DEPTH, LEVELS, TILING, TILING_SIZE,
+    COMPRESSION, ATTRIBUTES, TILE_HEIGHT, TILE_WIDTH };
+static const int num_properties = 16;
+
+namespace {
+
+// Errors raised by the threads of a parallel region. The first one is
+// kept, whatever its type, and rethrown once the region is done
+class ParallelErrors {
+public:
+    ParallelErrors() : _failed(false) {}
+
+    bool failed() const
+    {
+        return _failed;
+    }
+
+    // Keeps the exception being handled, from a catch block
+    void capture()
+    {
+        capture(std::current_exception());
+    }
+
+    void capture(std::exception_ptr error)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        if ( !_error )
+            _error = error;
+        _failed = true;
+    }
+
+    // Finalizes an array opened by a thread, if any
+    void finalize(TileDB_Array* array)
+    {
+        if ( array != NULL && tiledb_array_finalize(array) == TILEDB_ERR )
+            capture(std::make_exception_ptr(VCLException(TileDBError,
+                "TileDB array failed to finalize")));
+    }
+
+    void rethrow()
+    {
+        if ( _failed )
+            std::rethrow_exception(_error);
+    }
+
+private:
+    std::atomic<bool> _failed;
+    std::mutex _lock;
+    std::exception_ptr _error;
+};
+
+}
+
     /*  *********************** */
     /*        CONSTRUCTORS      */
     /*  *********************** */
@@ -52,16 +124,17 @@ TDBImage::TDBImage() : TDBObject()
     _img_width = 0;
     _img_channels = 0;
     _img_size = 0;
+    _img_depth = CV_8U;
 
     _threshold = 0;
+    _threshold_pending = false;
+    _pyramid_levels = 0;
 
     set_num_dimensions(2);
 
     set_default_attributes();
     set_default_dimensions();
 
-    _raw_data = NULL;
-    _tile_order = false;
 }
 
 TDBImage::TDBImage(const std::string &image_id) : TDBObject(image_id)
@@ -70,15 +143,16 @@ TDBImage::TDBImage(const std::string &image_id) : TDBObject(image_id)
     _img_width = 0;
     _img_channels = 0;
     _img_size = 0;
+    _img_depth = CV_8U;
 
     _threshold = 0;
+    _threshold_pending = false;
+    _pyramid_levels = 0;
 
     set_num_dimensions(2);
     set_default_attributes();
     set_default_dimensions();
 
-    _raw_data = NULL;
-    _tile_order = false;
 }
 
 template <class T>
@@ -88,16 +162,17 @@ TDBImage::TDBImage(T* buffer, int size) : TDBObject()
     _img_width = 0;
     _img_channels = 0;
     _img_size = size;
+    _img_depth = cv::DataType<T>::depth;
 
     _threshold = 0;
+    _threshold_pending = false;
+    _pyramid_levels = 0;
 
     set_num_dimensions(2);
     set_default_attributes();
     set_default_dimensions();
 
-    _raw_data = new unsigned char[size];
-    std::memcpy(_raw_data, buffer, _img_size);
-    _tile_order = false;
+    _raw_data = cv::Mat(1, _img_size, CV_MAKETYPE(_img_depth, 1), buffer).clone();
 }
 
 // OpenCV type CV_8UC1-4
@@ -123,44 +198,57 @@ TDBImage::TDBImage(TDBImage &tdb) : TDBObject(tdb)
             tdb.read();
         }
         catch ( VCL::Exception &e ) {
-            _raw_data = NULL;
         }
     }
 
     set_equal(tdb);
     set_image_data_equal(tdb);
 
-    if ( tdb.has_data() ) {
-        _raw_data = new unsigned char[_img_size];
-        std::memcpy(_raw_data, tdb._raw_data, _img_size);
-    }
+    // Operations never modify the data in place, so it can be shared
+    _raw_data = tdb._raw_data;
 }
 
 void TDBImage::operator=(TDBImage &tdb)
 {
-    unsigned char *temp = _raw_data;
-
     if ( !tdb.has_data() ) {
         try {
             tdb.read();
         }
         catch ( VCL::Exception &e ) {
-            _raw_data = NULL;
         }
     }
 
     set_equal(tdb);
     set_image_data_equal(tdb);
 
-    if ( tdb.has_data() ) {
-        if (_raw_data != NULL)
-            delete [] _raw_data;
+    if ( tdb.has_data() )
+        _raw_data = tdb._raw_data;
+}
 
-        _raw_data = new unsigned char[_img_size];
-        std::memcpy(_raw_data, tdb._raw_data, _img_size);
-    }
+void TDBImage::share(const TDBImage &tdb)
+{
+    set_equal(tdb);
+    set_image_data_equal(tdb);
 
-    delete temp;
+    _raw_data = tdb._raw_data;
+}
+
+TDBImage::TDBImage(TDBImage &&tdb) noexcept
+    : TDBObject(std::move(tdb))
+{
+    set_image_data_equal(tdb);
+    _raw_data = std::move(tdb._raw_data);
+    tdb._raw_data.release();
+}
+
+TDBImage& TDBImage::operator=(TDBImage &&tdb) noexcept
+{
+    TDBObject::operator=(std::move(tdb));
+
+    set_image_data_equal(tdb);
+    std::swap(_raw_data, tdb._raw_data);
+
+    return *this;
 }
 
 void TDBImage::set_image_data_equal(const TDBImage &tdb)
@@ -169,13 +257,14 @@ void TDBImage::set_image_data_equal(const TDBImage &tdb)
     _img_width = tdb._img_width;
     _img_channels = tdb._img_channels;
     _img_size = tdb._img_size;
+    _img_depth = tdb._img_depth;
     _threshold = tdb._threshold;
-    _tile_order = tdb._tile_order;
+    _threshold_pending = tdb._threshold_pending;
+    _pyramid_levels = tdb._pyramid_levels;
 }
 
 TDBImage::~TDBImage()
 {
-    delete [] _raw_data;
 }
 
 
@@ -223,31 +312,56 @@ int TDBImage::get_image_channels()
     return _img_channels;
 }
 
-cv::Mat TDBImage::get_cvmat()
+int TDBImage::get_image_type()
 {
-    if ( _raw_data == NULL )
-        read();
+    if (_img_channels == 0 && _name == "")
+        throw VCLException(TileDBNotFound, "No data in TileDB object yet");
+    else if ( _img_channels == 0 && _name != "")
+        read_metadata();
 
-    unsigned char* buffer = new unsigned char[_img_size];
+    return CV_MAKETYPE(_img_depth, _img_channels);
+}
 
-    if ( _tile_order )
-        reorder_buffer(buffer);
-    else
-        std::memcpy(buffer, _raw_data, _img_size);
+int TDBImage::get_pyramid_levels()
+{
+    if ( _img_height == 0 && _name != "" )
+        read_metadata();
 
-    cv::Mat img_clone;
+    return _pyramid_levels;
+}
 
-    if ( _img_channels == 1 ) {
-        cv::Mat img(cv::Size(_img_width, _img_height), CV_8UC1, buffer);
-        img_clone = img.clone();
-    }
-    else {
-        cv::Mat img(cv::Size(_img_width, _img_height), CV_8UC3, buffer);
-        img_clone = img.clone();
+int TDBImage::get_tile_height()
+{
+    if ( _img_height == 0 && _name != "" )
+        read_metadata();
+
+    // Images stored before the tile extents were kept only have them
+    // in the schema
+    if ( _tile_dimension.size() < 2 || _tile_dimension[0] == 0 ) {
+        if ( _name == "" )
+            throw VCLException(TileDBNotFound, "No data in TileDB object yet");
+
+        std::string array_name = _group + _name;
+        TileDB_Array* tiledb_array;
+        Error_Check(
+            tiledb_array_init(_ctx, &tiledb_array, array_name.c_str(),
+                TILEDB_ARRAY_READ, NULL, NULL, 0),
+            "TileDB array initialization failed");
+        set_from_schema(tiledb_array);
+        Error_Check(
+            tiledb_array_finalize(tiledb_array),
+            "TileDB array failed to finalize");
     }
 
-    delete [] buffer;
-    return img_clone;
+    return _tile_dimension[0];
+}
+
+cv::Mat TDBImage::get_cvmat()
+{
+    if ( _raw_data.empty() )
+        read();
+
+    return _raw_data;
 }
 
 template <class T>
@@ -257,13 +371,13 @@ void TDBImage::get_buffer(T* buffer, int buffer_size)
         throw VCLException(SizeMismatch, buffer_size + " is not equal to "
             + get_image_size());
 
-    if ( _raw_data == NULL )
+    if ( _raw_data.empty() )
         read();
 
-    if ( _tile_order ) 
-        reorder_buffer(buffer);
-    else
-        std::memcpy(buffer, _raw_data, buffer_size);
+    // Converts the values if T is not the type the image is stored as
+    cv::Mat typed(_raw_data.rows, _raw_data.cols,
+        CV_MAKETYPE(cv::DataType<T>::depth, _raw_data.channels()), buffer);
+    _raw_data.convertTo(typed, typed.type());
 }
 
 template void TDBImage::get_buffer(unsigned char* buffer, int buffer_size);
@@ -285,6 +399,19 @@ void TDBImage::set_image_properties(int height, int width, int channels)
     _img_width = width;
     _img_channels = channels;
     _img_size = _img_height * _img_width * _img_channels;
+
+    // Data from a raw buffer is a single row until the shape is known
+    if ( !_raw_data.empty() && int(_raw_data.total() * _raw_data.channels()) == _img_size )
+        _raw_data = _raw_data.reshape(_img_channels, _img_height);
+}
+
+void TDBImage::set_pyramid_levels(int levels)
+{
+    if ( levels < 0 )
+        throw VCLException(UnsupportedOperation, "The number of pyramid \
+            levels cannot be negative");
+
+    _pyramid_levels = levels;
 }
 
 
@@ -294,63 +421,17 @@ void TDBImage::set_image_properties(int height, int width, int channels)
     /*  *********************** */
 void TDBImage::write(const std::string &image_id, bool metadata)
 {
-    if ( _raw_data == NULL )
+    if ( _raw_data.empty() )
         throw VCLException(ObjectEmpty, "No data to be written");
 
     std::string array_name = workspace_setup(image_id);
-    int num_values = array_setup(array_name, metadata);
+    array_setup(array_name, metadata);
 
-    TileDB_Array* image_array;
+    // The array may be padded to a multiple of the tile size
+    int64_t subarray[] = { 0, _img_height - 1, 0, _img_width - 1 };
+    write_to_tdb(array_name, _raw_data, subarray);
 
-    if ( _tile_order ) {
-        Error_Check(
-            tiledb_array_init(_ctx, &image_array, array_name.c_str(),
-                TILEDB_ARRAY_WRITE, NULL, NULL, 0),
-            "TileDB array failed to initialize");
-    }
-    else {
-        Error_Check(
-            tiledb_array_init(_ctx, &image_array, array_name.c_str(),
-                TILEDB_ARRAY_WRITE_SORTED_ROW, NULL, NULL, 0),
-            "TileDB array failed to initialize");
-    }
-
-
-    if ( _num_attributes == 1 ) {
-        // Size of buffers is equal to the number of attributes
-        const void* buffers[] = { _raw_data };
-        size_t buffer_sizes[] = { sizeof(_raw_data) };
-
-        Error_Check(
-            tiledb_array_write(image_array, buffers, buffer_sizes),
-            "TileDB write to array failed");
-    }
-    else {
-        size_t buffer_size = _img_height*_img_width;
-        unsigned char* blue_buffer = new unsigned char[buffer_size];
-        unsigned char* green_buffer = new unsigned char[buffer_size];
-        unsigned char* red_buffer = new unsigned char[buffer_size];
-
-        int count = 0;
-        for ( int i = 0; i < buffer_size; ++i ) {
-            blue_buffer[i] = _raw_data[count];
-            green_buffer[i] = _raw_data[count + 1];
-            red_buffer[i] = _raw_data[count + 2];
-        }
-
-        // Size of buffers is equal to the number of attributes
-        const void* buffers[] = { blue_buffer, green_buffer, red_buffer };
-        size_t buffer_sizes[] = { buffer_size, buffer_size, buffer_size };
-
-        Error_Check(
-            tiledb_array_write(image_array, buffers, buffer_sizes),
-            "TileDB write to array failed");
-
-    }
-
-    Error_Check(
-        tiledb_array_finalize(image_array),
-        "TileDB array failed to finalize");
+    write_pyramid(array_name);
 }
 
 
@@ -368,85 +449,82 @@ void TDBImage::write(const cv::Mat &cv_img, bool metadata)
     _img_width = cv_img.cols;
     _img_channels = cv_img.channels();
     _img_size = _img_height * _img_width * _img_channels;
+    _img_depth = cv_img.depth();
 
     std::string array_name = workspace_setup(_group + _name);
-    int num_values = array_setup(array_name, metadata);
+    array_setup(array_name, metadata);
 
-    TileDB_Array* image_array;
-    Error_Check(
-        tiledb_array_init(_ctx, &image_array, array_name.c_str(),
-            TILEDB_ARRAY_WRITE_SORTED_ROW, NULL, NULL, 0),
-        "TileDB array failed to initialize");
+    // Keep a continuous copy so the written data can be returned later
+    _raw_data = cv_img.clone();
 
-    size_t buffer_size = _img_height * _img_width * _img_channels;
+    // The array may be padded to a multiple of the tile size
+    int64_t subarray[] = { 0, _img_height - 1, 0, _img_width - 1 };
+    write_to_tdb(array_name, _raw_data, subarray);
 
-    if ( _num_attributes == 1 ) {
-        _raw_data = new unsigned char[buffer_size];
-        std::memcpy(_raw_data, cv_img.data, buffer_size);
-        _tile_order = false;
+    write_pyramid(array_name);
+}
 
-        // Size of buffers is equal to the number of attributes
-        const void* buffers[] = { _raw_data };
-        size_t buffer_sizes[] = { buffer_size };
+void TDBImage::begin_write(int height, int width, int type, bool metadata)
+{
+    if ( _group == "" )
+        throw VCLException(ObjectNotFound, "Object path is not defined");
+    if ( _name == "" )
+        throw VCLException(ObjectNotFound, "Object name is not defined");
+    if ( _pyramid_levels > 0 )
+        throw VCLException(UnsupportedOperation, "Pyramid levels need the \
+            whole image and cannot be written area by area");
 
-        Error_Check(
-            tiledb_array_write(image_array, buffers, buffer_sizes),
-            "TileDB write to array failed");
-    }
-    else {
-        std::vector<cv::Mat> channels(3);
-        cv::split(cv_img, channels);
-        size_t size = _img_height * _img_width;
-        unsigned char* blue_buffer = new unsigned char[size];
-        unsigned char* green_buffer = new unsigned char[size];
-        unsigned char* red_buffer = new unsigned char[size];
-
-        const unsigned char* bp;
-        for ( int i = 0; i < _img_height; ++i ) {
-            bp = channels[0].ptr<unsigned char>(i);
-            unsigned char* b = &blue_buffer[i * _img_width];
-            std::memcpy(b, bp, _img_width);
-        }
+    _raw_data.release();
 
-        const unsigned char* gp;
-        for ( int i = 0; i < _img_height; ++i ) {
-            gp = channels[1].ptr<unsigned char>(i);
-            unsigned char* g = &green_buffer[i * _img_width];
-            std::memcpy(g, gp, _img_width);
-        }
+    std::vector<int> values = { height, width };
+    set_dimension_values(values);
 
-        const unsigned char* rp;
-        for ( int i = 0; i < _img_height; ++i ) {
-            rp = channels[2].ptr<unsigned char>(i);
-            unsigned char* r = &red_buffer[i * _img_width];
-            std::memcpy(r, rp, _img_width);
-        }
+    _img_height = height;
+    _img_width = width;
+    _img_channels = CV_MAT_CN(type);
+    _img_size = _img_height * _img_width * _img_channels;
+    _img_depth = CV_MAT_DEPTH(type);
 
-        _raw_data = new unsigned char[buffer_size];
-        std::memcpy(_raw_data, cv_img.data, buffer_size);
-        _tile_order = false;
+    _write_array = workspace_setup(_group + _name);
+    array_setup(_write_array, metadata);
+}
 
-        // Size of buffers is equal to the number of attributes
-        const void* buffers[] = { blue_buffer, green_buffer, red_buffer };
-        size_t buffer_sizes[] = { size, size, size };
+void TDBImage::write_area(const cv::Mat &area, int row, int column)
+{
+    if ( _write_array == "" )
+        throw VCLException(UnsupportedOperation, "No write in progress, \
+            begin_write must be called first");
+    if ( area.type() != CV_MAKETYPE(_img_depth, _img_channels) )
+        throw VCLException(UnsupportedFormat, "The area does not have the \
+            type of the image being written");
+    if ( row < 0 || column < 0 || _img_height < row + area.rows
+        || _img_width < column + area.cols )
+        throw VCLException(SizeMismatch, "Area is not within the image");
+
+    int64_t subarray[] = { row, row + area.rows - 1,
+        column, column + area.cols - 1 };
+
+    write_to_tdb(_write_array, area, subarray);
+}
 
-        Error_Check(
-            tiledb_array_write(image_array, buffers, buffer_sizes),
-            "TileDB write to array failed");
+void TDBImage::end_write(bool consolidate)
+{
+    if ( _write_array == "" )
+        throw VCLException(UnsupportedOperation, "No write in progress, \
+            begin_write must be called first");
 
-        delete [] blue_buffer;
-        delete [] green_buffer;
-        delete [] red_buffer;
-    }
+    std::string array_name = _write_array;
+    _write_array = "";
 
-    Error_Check(
-        tiledb_array_finalize(image_array),
-        "TileDB array failed to finalize");
+    if ( consolidate )
+        Error_Check(
+            tiledb_array_consolidate(_ctx, array_name.c_str()),
+            "TileDB array failed to consolidate");
 }
 
 void TDBImage::read()
 {
-    if ( _raw_data == NULL )
+    if ( _raw_data.empty() )
     {
         if ( _img_height == 0 )
             read_metadata();
@@ -464,7 +542,7 @@ void TDBImage::read()
 
 void TDBImage::read(const Rectangle &rect)
 {
-    if (_raw_data == NULL) {
+    if ( _raw_data.empty() ) {
 
     if ( _img_height == 0 )
         read_metadata();
@@ -476,8 +554,8 @@ void TDBImage::read(const Rectangle &rect)
     _img_width = rect.width;
     _img_size = _img_height * _img_width * _img_channels;
 
-    int start_row = rect.x;
-    int start_column = rect.y;
+    int start_row = rect.y;
+    int start_column = rect.x;
     int end_row = start_row + rect.height - 1;
     int end_column = start_column + rect.width - 1;
 
@@ -487,73 +565,320 @@ void TDBImage::read(const Rectangle &rect)
     }
 }
 
+void TDBImage::crop(const Rectangle &rect)
+{
+    if ( _raw_data.empty() ) {
+        read(rect);
+        return;
+    }
+
+    if ( _img_height < rect.height + rect.y || _img_width < rect.width + rect.x )
+        throw VCLException(SizeMismatch, "Requested area is not within the image");
+
+    _raw_data = _raw_data(rect).clone();
+
+    _img_height = rect.height;
+    _img_width = rect.width;
+    _img_size = _img_height * _img_width * _img_channels;
+    std::vector<int> values = {_img_height, _img_width};
+    set_dimension_values(values);
+}
+
 void TDBImage::resize(const Rectangle &rect)
 {
-    if ( _raw_data == NULL )
-        read();
+    resize(rect, Rectangle(0, 0, rect.width, rect.height));
+}
+
+void TDBImage::resize(const Rectangle &rect, const Rectangle &area)
+{
+    if ( area.x < 0 || area.y < 0 || rect.width < area.width + area.x
+        || rect.height < area.height + area.y )
+        throw VCLException(SizeMismatch, "Requested area is not within the image");
 
-    int r, c;
+    cv::Size dst_size(rect.width, rect.height);
+    cv::Size src_size;
+    Rectangle src_area;
 
-    int data_index = 0;
-    unsigned char* image_buffer = new unsigned char[rect.height * rect.width * _img_channels];
+    if ( _raw_data.empty() && _img_height == 0 )
+        read_metadata();
 
-    float row_ratio = _img_height / float(rect.height);
-    float column_ratio = _img_width / float(rect.width);
+    cv::Mat resized;
 
-    for ( r = 0; r < rect.height; ++r ) {
-        float scale_r =  ( r + 0.5 ) * row_ratio - 0.5;
+    if ( _img_depth != CV_8U ) {
+        // The resize kernels and the pyramid levels are 8 bit only
+        read();
 
-        for ( c = 0; c < rect.width; ++c ) {
-            float scale_c =  ( c + 0.5 ) * column_ratio - 0.5;
+        cv::Mat full;
+        cv::resize(_raw_data, full, dst_size, 0, 0, cv::INTER_LINEAR);
+        resized = full(area).clone();
+    }
+    else {
+        if ( _raw_data.empty() )
+            src_area = read_level(dst_size, area, src_size);
+        else {
+            src_size = cv::Size(_img_width, _img_height);
+            src_area = Rectangle(cv::Point(0, 0), src_size);
+        }
 
-            data_index = rect.width * r * _img_channels + c * _img_channels;
+        resized.create(area.height, area.width, _raw_data.type());
 
-            get_index_value(image_buffer, data_index, scale_r, scale_c);
-         }
+        resize_bilinear(_raw_data.data, _raw_data.step, src_area, src_size,
+            resized.data, resized.step, area, dst_size, _img_channels);
     }
 
-    _img_height = rect.height;
-    _img_width = rect.width;
+    _img_height = area.height;
+    _img_width = area.width;
     _img_size = _img_height * _img_width * _img_channels;
     std::vector<int> values = {_img_height, _img_width};
     set_dimension_values(values);
 
-    _raw_data = new unsigned char[_img_size];
-    std::memcpy(_raw_data, image_buffer, _img_size);
-    _tile_order = false;
+    _raw_data = resized;
+}
+
+void TDBImage::resize_strips(cv::Size size, const StripFunction &function)
+{
+    if ( size.width <= 0 || size.height <= 0 )
+        throw VCLException(SizeMismatch, "Size must have at least one pixel");
+
+    if ( _img_height == 0 )
+        read_metadata();
+
+    if ( _img_depth != CV_8U )
+        throw VCLException(UnsupportedFormat, "The resize kernels are 8 bit only");
+
+    // Thresholding a level is not the same as thresholding the image
+    int level = _threshold_pending ? 0 : get_level(size);
+    std::string source_id = level == 0 ? _group + _name
+        : get_level_id(_group + _name, level);
+
+    TDBImage source(source_id);
+    cv::Size src_size(source.get_image_width(), source.get_image_height());
+    int tile_height = source.get_tile_height();
+    int type = source.get_image_type();
+
+    // A strip of output rows needs about one row of tiles, and one read
+    // covers a few rows of tiles so that they are read in parallel
+    float row_ratio = src_size.height / float(size.height);
+    int strip_rows = std::max(1, int(tile_height / row_ratio));
+    int read_rows = std::min(get_num_threads(), resize_read_tile_rows)
+        * tile_height;
+    source.set_num_threads(_num_threads);
+
+    // Whole rows of tiles of the source, from band_start
+    cv::Mat band;
+    int band_start = 0;
+
+    for ( int row = 0; row < size.height; row += strip_rows ) {
+        Rectangle dst_area(0, row, size.width,
+            std::min(strip_rows, size.height - row));
+        Rectangle src_area = resize_source_area(dst_area, src_size, size);
+        int src_end = src_area.y + src_area.height;
+
+        if ( band.empty() || band_start + band.rows < src_end ) {
+            // Rows of tiles above the strip are not needed again
+            int keep_start = src_area.y / tile_height * tile_height;
+            int read_start = std::max(keep_start, band_start + band.rows);
+            int read_end = std::min(src_size.height,
+                std::max(src_end, read_start + read_rows));
+            read_end = std::min(src_size.height,
+                (read_end + tile_height - 1) / tile_height * tile_height);
+
+            cv::Mat next(read_end - keep_start, src_size.width, type);
+            if ( read_start > keep_start ) {
+                cv::Mat kept(next, Rectangle(0, 0, src_size.width,
+                    read_start - keep_start));
+                band.rowRange(keep_start - band_start, band.rows).copyTo(kept);
+            }
+
+            cv::Mat added(next, Rectangle(0, read_start - keep_start,
+                src_size.width, read_end - read_start));
+            source.read_area(Rectangle(0, read_start, src_size.width,
+                read_end - read_start)).copyTo(added);
+
+            // The image is not loaded, so the threshold stays pending
+            if ( _threshold_pending )
+                threshold_area(added, added);
+
+            band = next;
+            band_start = keep_start;
+        }
+
+        cv::Mat strip(dst_area.height, size.width, type);
+        Rectangle band_area(0, band_start, src_size.width, band.rows);
+        resize_bilinear(band.data, band.step, band_area, src_size,
+            strip.data, strip.step, dst_area, size, CV_MAT_CN(type));
+
+        function(strip, row);
+    }
+}
+
+void TDBImage::resize_to(const std::string &image_id, cv::Size size,
+    bool metadata)
+{
+    if ( size.width <= 0 || size.height <= 0 )
+        throw VCLException(SizeMismatch, "Size must have at least one pixel");
+
+    if ( _img_height == 0 )
+        read_metadata();
+
+    TDBImage target(image_id);
+    target.set_num_attributes(_num_attributes);
+    target.set_compression(_compressed);
+    target.set_minimum(_min_tile_dimension);
+    target.set_tiling(_tiling, _tiling_size);
+
+    // Strips are gathered into writes of about the size of the strips
+    // written from memory, each write is a fragment
+    size_t row_size = size_t(size.width) * _img_channels;
+    int buffer_rows = std::min<size_t>(size.height,
+        std::max<size_t>(1, write_strip_size / row_size));
+    cv::Mat buffer(buffer_rows, size.width, CV_MAKETYPE(_img_depth, _img_channels));
+    int buffer_start = 0;
+    int buffered = 0;
+
+    resize_strips(size, [&](const cv::Mat &strip, int row) {
+        // Started with the first strip, once the size and type are valid
+        if ( row == 0 )
+            target.begin_write(size.height, size.width, strip.type(), metadata);
+
+        for ( int i = 0; i < strip.rows; ) {
+            int rows = std::min(strip.rows - i, buffer_rows - buffered);
+            cv::Mat target_rows = buffer.rowRange(buffered, buffered + rows);
+            strip.rowRange(i, i + rows).copyTo(target_rows);
+            buffered += rows;
+            i += rows;
+
+            if ( buffered == buffer_rows ) {
+                target.write_area(buffer, buffer_start, 0);
+                buffer_start += buffered;
+                buffered = 0;
+            }
+        }
+    });
 
-    delete [] image_buffer;
+    if ( buffered > 0 )
+        target.write_area(buffer.rowRange(0, buffered), buffer_start, 0);
+
+    target.end_write(true);
 }
 
 void TDBImage::threshold(int value)
 {
-    if ( _raw_data == NULL ) {
+    if ( _raw_data.empty() ) {
+        // Thresholds to zero in sequence keep the highest one
+        if ( _threshold_pending )
+            value = std::max(_threshold, value);
         _threshold = value;
-        read();
+        _threshold_pending = true;
     }
 
     else {
-        int length = _img_height * _img_width * _img_channels;
+        // Write to a new Mat, the current data may be shared
+        cv::Mat thresholded;
+        cv::threshold(_raw_data, thresholded, value, value, cv::THRESH_TOZERO);
+        _raw_data = thresholded;
+    }
+}
 
-        for ( int i = 0; i < length; ++i ) {
-            if ( _raw_data[i] <= value )
-                _raw_data[i] = 0;
+void TDBImage::for_each_tile(const TileFunction &function)
+{
+    visit_tiles(function, [](int, int) {});
+}
+
+void TDBImage::map_tiles(const std::string &image_id,
+    const TileMapFunction &function, bool metadata)
+{
+    // Reads the properties, and the schema if they lack the tile extents
+    get_tile_height();
+    int tile_width = _tile_dimension[1];
+
+    // Results of the tiles of the current row, by tile column
+    std::vector<cv::Mat> results((_img_width + tile_width - 1) / tile_width);
+
+    TDBImage target(image_id);
+    target.set_compression(_compressed);
+    target.set_minimum(_min_tile_dimension);
+    target.set_tiling(_tiling, _tiling_size);
+    int type = -1;
+
+    auto map_tile = [&](const cv::Mat &tile, const Rectangle &area) {
+        results[area.x / tile_width] = function(tile, area);
+    };
+
+    // Each row of tiles is written as one fragment
+    auto write_row = [&](int row, int rows) {
+        if ( type == -1 ) {
+            type = results[0].type();
+
+            // The target stores one or three attributes
+            if ( CV_MAT_CN(type) != 1 && CV_MAT_CN(type) != 3 )
+                throw VCLException(UnsupportedFormat, "The results of the \
+                    tiles must have one or three channels");
         }
-    }
+
+        for ( int i = 0; i < int(results.size()); ++i ) {
+            cv::Size size(std::min(tile_width, _img_width - i * tile_width), rows);
+
+            if ( results[i].size() != size )
+                throw VCLException(SizeMismatch, "The result of a tile does \
+                    not have the size of the tile");
+            if ( results[i].type() != type )
+                throw VCLException(UnsupportedFormat, "The results of the \
+                    tiles do not have the same type");
+        }
+
+        if ( row == 0 ) {
+            target.set_num_attributes(CV_MAT_CN(type) == 3 ? _num_attributes : 1);
+            target.begin_write(_img_height, _img_width, type, metadata);
+        }
+
+        cv::Mat strip(rows, _img_width, type);
+        for ( int i = 0; i < int(results.size()); ++i ) {
+            cv::Mat strip_area(strip, Rectangle(cv::Point(i * tile_width, 0),
+                results[i].size()));
+            results[i].copyTo(strip_area);
+            results[i].release();
+        }
+
+        target.write_area(strip, row, 0);
+    };
+
+    visit_tiles(map_tile, write_row);
+    target.end_write(true);
+}
+
+void TDBImage::threshold_tiles(const std::string &image_id, int value)
+{
+    map_tiles(image_id, [value](const cv::Mat &tile, const Rectangle &) {
+        cv::Mat thresholded;
+        cv::threshold(tile, thresholded, value, value, cv::THRESH_TOZERO);
+        return thresholded;
+    });
 }
 
 bool TDBImage::has_data()
 {
-    if ( _raw_data == NULL )
-        return false;
-    else
-        return true;
+    return !_raw_data.empty();
 }
 
 void TDBImage::delete_image()
 {
-    delete _raw_data;
-    _raw_data = NULL;
+    _raw_data.release();
+
+    try {
+        get_pyramid_levels();
+    }
+    catch ( VCL::Exception &e ) {
+    }
+
+    for ( int level = 1; level <= _pyramid_levels; ++level ) {
+        std::string level_id = get_level_id(_group + _name, level);
+        TDBMetadataCache::instance().erase(level_id);
+        Error_Check(
+            tiledb_delete(_ctx, level_id.c_str()),
+            "TileDB delete failed");
+    }
+
     delete_object();
 }
 
@@ -570,110 +895,117 @@ std::string TDBImage::get_parent_dir(const std::string &filename) const
     return parent_dir.substr(0, loc + 1);
 }
 
-
-
-void TDBImage::get_tile_coordinates(int64_t* subarray, int current_row_tile, int current_column_tile)
+std::string TDBImage::get_level_id(const std::string &image_id, int level) const
 {
-    int row_start = current_row_tile * _tile_dimension[0];
-    int column_start = current_column_tile * _tile_dimension[1];
-    int row_end = row_start + _tile_dimension[0];
-    int column_end = column_start + _tile_dimension[1];
-
-    if (row_end > _img_height)
-        row_end = (_img_height - row_start) + row_start;
-
-    if (column_end > _img_width)
-        column_end = (_img_width - column_start) + column_start;
-
-    subarray[0] = row_start;
-    subarray[1] = row_end;
-    subarray[2] = column_start;
-    subarray[3] = column_end;
+    return image_id + "_level" + std::to_string(level);
 }
 
-void TDBImage::get_index_value(unsigned char* image_buffer, int index,
-    float scale_r, float scale_c)
+int TDBImage::get_level(cv::Size size) const
 {
-    int column_left = floor(scale_c);
-    int column_right = floor(scale_c + 1);
-    int row_top = floor(scale_r);
-    int row_bottom = floor(scale_r + 1);
-
-    if ( column_left < 0 )
-        column_left = 0;
-    if ( column_right > _img_width - 1 )
-        column_right = _img_width - 1;
-
-    if ( row_top < 0 )
-        row_top = 0;
-    if ( row_bottom > _img_height - 1 )
-        row_bottom = _img_height - 1;
-
-    int top_left_index = get_index(row_top, column_left) * _img_channels;
-    int top_right_index = get_index(row_top, column_right) * _img_channels;
-    int bottom_left_index = get_index(row_bottom, column_left) * _img_channels;
-    int bottom_right_index = get_index(row_bottom, column_right) * _img_channels;
-
-    for ( int x = 0; x < _img_channels; ++x ) {
-        unsigned char top_left = _raw_data[top_left_index + x];
-        unsigned char top_right = _raw_data[top_right_index + x];
-        unsigned char bottom_left = _raw_data[bottom_left_index + x];
-        unsigned char bottom_right = _raw_data[bottom_right_index + x];
+    int level = 0;
+    while ( level < _pyramid_levels
+        && (_img_height >> (level + 1)) >= size.height
+        && (_img_width >> (level + 1)) >= size.width )
+        ++level;
 
-        double top = linear_interpolation(column_left, top_left, column_right, top_right, scale_c);
-        double bottom = linear_interpolation(column_left, bottom_left, column_right, bottom_right, scale_c);
-        double middle = linear_interpolation(row_top, top, row_bottom, bottom, scale_r);
-
-        // we want the middle of the pixel
-        unsigned char pixel_value = floor(middle + 0.5);
-        image_buffer[ index + x ] = pixel_value;
-    }
+    return level;
 }
 
-int TDBImage::get_index(int row, int column) const
+std::vector<int64_t> TDBImage::get_properties() const
 {
-    int tile_width = get_tile_width(column, _img_width / _tile_dimension[1]);
-    int tile_height = get_tile_height(row, _img_height / _tile_dimension[0]);
-
-    int tile_size = tile_width * tile_height;
-
-    int current_tile_row = row % int(_tile_dimension[0]);
-    int current_row_tile = row / int(_tile_dimension[0]);
-    int current_column_tile = column / int(_tile_dimension[1]);
-    int current_tile_column = column % int(_tile_dimension[1]);
-
-    int full_row_tile = _img_width * _tile_dimension[0];
-
-    int row_index = current_row_tile * full_row_tile + current_tile_row * tile_width;
-    int column_index = current_column_tile * tile_size + current_tile_column;
+    std::vector<int64_t> properties(num_properties, 0);
+
+    properties[HEIGHT] = _img_height;
+    properties[WIDTH] = _img_width;
+    properties[CHANNELS] = _img_channels;
+    properties[DEPTH] = _img_depth;
+    properties[LEVELS] = _pyramid_levels;
+    properties[TILING] = int(_tiling);
+    properties[TILING_SIZE] = _tiling_size;
+    properties[COMPRESSION] = int(_compressed);
+    properties[ATTRIBUTES] = _num_attributes;
+
+    if ( _tile_dimension.size() == 2 ) {
+        properties[TILE_HEIGHT] = _tile_dimension[0];
+        properties[TILE_WIDTH] = _tile_dimension[1];
+    }
 
-    return row_index + column_index;
+    return properties;
 }
 
-int TDBImage::get_tile_height(int row, int number_tiles) const
+int TDBImage::get_tiledb_type(int depth) const
 {
-    int tile_height = int(_tile_dimension[0]);
-
-    if ( row / _tile_dimension[0] == number_tiles )
-        tile_height = _img_height - (number_tiles) * _tile_dimension[0];
-
-    return tile_height;
+    switch ( depth ) {
+        case CV_8U:
+            return TILEDB_CHAR;
+        case CV_8S:
+            return TILEDB_INT8;
+        case CV_16U:
+            return TILEDB_UINT16;
+        case CV_16S:
+            return TILEDB_INT16;
+        case CV_32S:
+            return TILEDB_INT32;
+        case CV_32F:
+            return TILEDB_FLOAT32;
+        case CV_64F:
+            return TILEDB_FLOAT64;
+        default:
+            throw VCLException(UnsupportedFormat, std::to_string(depth)
+                + " is not a supported depth");
+    }
 }
 
-int TDBImage::get_tile_width(int column, int number_tiles) const
+int TDBImage::get_cv_depth(int type) const
 {
-    int tile_width = int(_tile_dimension[1]);
-
-    if ( column / _tile_dimension[1] == number_tiles )
-        tile_width = _img_width - (number_tiles) * _tile_dimension[1];
-
-    return tile_width;
+    switch ( type ) {
+        case TILEDB_CHAR:
+        case TILEDB_UINT8:
+            return CV_8U;
+        case TILEDB_INT8:
+            return CV_8S;
+        case TILEDB_UINT16:
+            return CV_16U;
+        case TILEDB_INT16:
+            return CV_16S;
+        case TILEDB_INT32:
+            return CV_32S;
+        case TILEDB_FLOAT32:
+            return CV_32F;
+        case TILEDB_FLOAT64:
+            return CV_64F;
+        default:
+            throw VCLException(UnsupportedFormat, std::to_string(type)
+                + " is not a supported TileDB type");
+    }
 }
 
 
     /*  *********************** */
     /*   PRIVATE SET FUNCTIONS  */
     /*  *********************** */
+void TDBImage::set_properties(const std::vector<int64_t> &properties)
+{
+    _img_height = properties[HEIGHT];
+    _img_width = properties[WIDTH];
+    _img_channels = properties[CHANNELS];
+    _img_depth = properties[DEPTH];
+    _img_size = _img_height * _img_width * _img_channels;
+    _pyramid_levels = properties[LEVELS];
+    _tiling = TilingPolicy(properties[TILING]);
+    _tiling_size = properties[TILING_SIZE];
+    if ( properties[ATTRIBUTES] > 0 )
+        set_num_attributes(properties[ATTRIBUTES]);
+
+    // Images stored before the tile extents were kept have 0
+    if ( properties[TILE_HEIGHT] > 0 )
+        _tile_dimension = { int(properties[TILE_HEIGHT]),
+            int(properties[TILE_WIDTH]) };
+
+    std::vector<int> values = { _img_height, _img_width };
+    set_dimension_values(values);
+}
+
 void TDBImage::set_default_dimensions()
 {
     _dimension_names.push_back("height");
@@ -721,35 +1053,119 @@ int TDBImage::array_setup(const std::string &image_id, bool metadata)
     else
         num_values = 1;
 
+    _type = get_tiledb_type(_img_depth);
     set_schema(num_values, image_id);
 
-    if (metadata) {
-        int64_t buffer[_num_dimensions + 1];
-        size_t buffer_keys[_num_dimensions + 1];
+    // Every level halves the previous one, down to a single pixel
+    int max_levels = 0;
+    while ( (std::min(_img_height, _img_width) >> (max_levels + 1)) > 0 )
+        ++max_levels;
+    _pyramid_levels = std::min(_pyramid_levels, max_levels);
 
-        buffer[0] = _img_height;
-        buffer[1] = _img_width;
-        buffer[2] = _img_channels;
+    if (metadata) {
+        std::vector<int64_t> properties = get_properties();
 
-        buffer_keys[0] = 0;
-        buffer_keys[1] = 5;
-        buffer_keys[2] = 13;
+        size_t buffer_keys[] = { 0 };
+        char buffer_var_keys[] = { "properties" };
 
-        char buffer_var_keys[] = { "rows\0columns\0channels" };
+        std::string md_name = image_id + "/properties";
 
-        std::string md_name = image_id + "/metadata";
+        // A single key holds every property, so it is read at once
+        write_metadata(md_name, properties.data(), buffer_var_keys,
+            buffer_keys, sizeof(buffer_var_keys), 1, num_properties);
 
-        write_metadata(md_name, buffer, buffer_var_keys, buffer_keys, sizeof(buffer_var_keys));
+        TDBMetadataCache::instance().set(image_id, properties);
     }
+    else
+        TDBMetadataCache::instance().erase(image_id);
 
     return num_values;
 }
 
+void TDBImage::write_pyramid(const std::string &image_id)
+{
+    cv::Mat level = _raw_data;
+
+    for ( int x = 1; x <= _pyramid_levels; ++x ) {
+        cv::Size src_size(level.cols, level.rows);
+        cv::Size dst_size(level.cols / 2, level.rows / 2);
+        cv::Mat half(dst_size, level.type());
+
+        // With a ratio of two, bilinear interpolation averages 2x2 blocks
+        if ( _img_depth == CV_8U )
+            resize_bilinear(level.data, level.step,
+                Rectangle(cv::Point(0, 0), src_size), src_size,
+                half.data, half.step,
+                Rectangle(cv::Point(0, 0), dst_size), dst_size, _img_channels);
+        else
+            cv::resize(level, half, dst_size, 0, 0, cv::INTER_AREA);
+
+        TDBImage level_tdb(get_level_id(image_id, x));
+        level_tdb.set_num_attributes(_num_attributes);
+        level_tdb.set_compression(_compressed);
+        level_tdb.set_minimum(_min_tile_dimension);
+        level_tdb.set_tiling(_tiling, _tiling_size);
+        level_tdb.write(half);
+
+        level = half;
+    }
+}
+
 
     /*  *********************** */
     /*   METADATA INTERACTION   */
     /*  *********************** */
 void TDBImage::read_metadata()
+{
+    std::string array_name = _group + _name;
+    std::vector<int64_t> properties;
+
+    if ( !TDBMetadataCache::instance().get(array_name, properties) ) {
+        std::string md_name = array_name + "/properties";
+
+        // Images written before the properties were kept under a single
+        // key have one key per property
+        if ( tiledb_dir_type(_ctx, md_name.c_str()) == TILEDB_METADATA )
+            properties = read_properties(md_name);
+        else
+            properties = read_legacy_metadata();
+
+        TDBMetadataCache::instance().set(array_name, properties);
+    }
+
+    set_properties(properties);
+}
+
+std::vector<int64_t> TDBImage::read_properties(const std::string &md_name)
+{
+    const char* attributes[] = { "dimensions" };
+    int attrs = 1;
+
+    TileDB_Metadata* md;
+    Error_Check(
+        tiledb_metadata_init(_ctx, &md, md_name.c_str(),
+            TILEDB_METADATA_READ, attributes, attrs),
+        "TileDB metadata failed to initialize");
+
+    std::vector<int64_t> properties(num_properties, 0);
+    void* buffers[] = { properties.data() };
+    size_t buffer_sizes[] = { num_properties * sizeof(int64_t) };
+
+    Error_Check(
+        tiledb_metadata_read(md, "properties", buffers, buffer_sizes),
+        "TileDB metadata read failed");
+
+    Error_Check(
+        tiledb_metadata_finalize(md),
+        "TileDB metadata failed to finalize");
+
+    if ( buffer_sizes[0] < num_properties * sizeof(int64_t) )
+        throw VCLException(TileDBError, "TileDB metadata is incomplete");
+
+    return properties;
+}
+
+std::vector<int64_t> TDBImage::read_legacy_metadata()
 {
     if ( tiledb_dir_type(_ctx, _group.c_str()) != TILEDB_GROUP )
         throw VCLException(TileDBNotFound, "Not a TileDB object");
@@ -768,6 +1184,9 @@ void TDBImage::read_metadata()
             TILEDB_METADATA_READ, attributes, attrs),
         "TileDB metadata failed to initialize");
 
+    // Properties without a key are 0, which is CV_8U for the depth
+    std::vector<int64_t> properties(num_properties, 0);
+
     const char* keys[] = { "rows", "columns", "channels" };
 
     int64_t rbuffer[10];
@@ -777,8 +1196,7 @@ void TDBImage::read_metadata()
     Error_Check(
         tiledb_metadata_read(md, keys[0], rbuffers, rbuffer_sizes),
         "TileDB metadata read failed");
-    _img_height = static_cast<int64_t*>(rbuffers[0])[0];
-    _dimension_values.push_back(_img_height);
+    properties[HEIGHT] = static_cast<int64_t*>(rbuffers[0])[0];
 
     int64_t cbuffer[10];
     void* cbuffers[] = { cbuffer };
@@ -787,8 +1205,7 @@ void TDBImage::read_metadata()
     Error_Check(
         tiledb_metadata_read(md, keys[1], cbuffers, cbuffer_sizes),
         "TileDB metadata read failed");
-    _img_width = static_cast<int64_t*>(cbuffers[0])[0];
-    _dimension_values.push_back(_img_width);
+    properties[WIDTH] = static_cast<int64_t*>(cbuffers[0])[0];
 
     int64_t hbuffer[10];
     void* hbuffers[] = { hbuffer };
@@ -797,13 +1214,35 @@ void TDBImage::read_metadata()
     Error_Check(
         tiledb_metadata_read(md, keys[2], hbuffers, hbuffer_sizes),
         "TileDB metadata read failed");
-    _img_channels = static_cast<int64_t*>(hbuffers[0])[0];
+    properties[CHANNELS] = static_cast<int64_t*>(hbuffers[0])[0];
 
-    _img_size = _img_height * _img_width * _img_channels;
+    // Images written before pyramids were supported have no levels key
+    int64_t lbuffer[10];
+    void* lbuffers[] = { lbuffer };
+    size_t lbuffer_sizes[] = { sizeof(lbuffer) };
+
+    Error_Check(
+        tiledb_metadata_read(md, "levels", lbuffers, lbuffer_sizes),
+        "TileDB metadata read failed");
+    if ( lbuffer_sizes[0] >= sizeof(int64_t) )
+        properties[LEVELS] = static_cast<int64_t*>(lbuffers[0])[0];
+
+    // Images written before other types were supported are 8 bit
+    int64_t tbuffer[10];
+    void* tbuffers[] = { tbuffer };
+    size_t tbuffer_sizes[] = { sizeof(tbuffer) };
+
+    Error_Check(
+        tiledb_metadata_read(md, "type", tbuffers, tbuffer_sizes),
+        "TileDB metadata read failed");
+    if ( tbuffer_sizes[0] >= sizeof(int64_t) )
+        properties[DEPTH] = static_cast<int64_t*>(tbuffers[0])[0];
 
     Error_Check(
         tiledb_metadata_finalize(md),
         "TileDB metadata failed to finalize");
+
+    return properties;
 }
 
 
@@ -812,10 +1251,12 @@ void TDBImage::read_metadata()
     /*  *********************** */
 void TDBImage::read_from_tdb(int64_t* subarray)
 {
-    std::string array_name = _group + _name;
+    if ( TDBTileCache::instance().get_capacity() > 0 ) {
+        read_from_tiles(subarray);
+        return;
+    }
 
-    size_t buffer_size = _img_size;
-    _raw_data = new unsigned char[buffer_size];
+    std::string array_name = _group + _name;
 
     TileDB_Array* tiledb_array;
     Error_Check(
@@ -823,146 +1264,560 @@ void TDBImage::read_from_tdb(int64_t* subarray)
             TILEDB_ARRAY_READ, subarray, NULL, 0),
         "TileDB array initialization failed");
 
+    // The schema has the type even if the metadata is not stored
     set_from_schema(tiledb_array);
+    _img_depth = get_cv_depth(_type);
 
-    if ( _num_attributes == 1 ) {
-        unsigned char* buffer = new unsigned char[buffer_size];
-        void* buffers[] = { buffer }; // Size of buffers is equal to the number of attributes
-        size_t buffer_sizes[] = { buffer_size };
+    _raw_data.create(_img_height, _img_width, CV_MAKETYPE(_img_depth, _img_channels));
 
-        int overflow = 0;
-        do {
-            Error_Check(
-                tiledb_array_read(tiledb_array, buffers, buffer_sizes),
-                "TileDB read failed");
-            overflow = tiledb_array_overflow(tiledb_array, 0);
-            Error_Check(overflow, "TileDB Array Overflow error");
-        } while ( overflow == 1);
+    // Each strip covers one row of tiles, so the strips can be read
+    // independently and placed at their own rows of the image
+    int64_t tile_height = _tile_dimension[0];
+    int64_t tile_width = _tile_dimension[1];
+    int64_t first_tile = subarray[0] / tile_height;
+    int num_strips = subarray[1] / tile_height - first_tile + 1;
+    int num_threads = std::min(get_num_threads(), num_strips);
 
-        std::memcpy(_raw_data, buffer, buffer_size);
+    // Within a single column of tiles the global order is row major,
+    // so a single attribute can be read straight into the image
+    bool in_place = _num_attributes == 1
+        && subarray[2] / tile_width == subarray[3] / tile_width;
 
-        Error_Check(
-            tiledb_array_finalize(tiledb_array),
-            "TileDB array failed to finalize");
+    size_t row_size = subarray[3] - subarray[2] + 1;
+    size_t cell_size = (_num_attributes == 1 ? _img_channels : 1)
+        * _raw_data.elemSize1();
 
-        _tile_order = true;
+    ParallelErrors errors;
 
-        delete [] buffer;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        // Thread 0 reuses the array opened for the schema
+        TileDB_Array* strip_array = NULL;
+        if ( omp_get_thread_num() == 0 )
+            strip_array = tiledb_array;
+
+        std::vector<unsigned char> strip_data;
+
+        #pragma omp for schedule(dynamic)
+        for ( int i = 0; i < num_strips; ++i ) {
+            if ( errors.failed() )
+                continue;
+
+            int64_t strip[] = {
+                std::max(subarray[0], (first_tile + i) * tile_height),
+                std::min(subarray[1], (first_tile + i + 1) * tile_height - 1),
+                subarray[2], subarray[3] };
+
+            size_t length = (strip[1] - strip[0] + 1) * row_size * cell_size;
+
+            // One buffer per attribute
+            unsigned char* planes[3];
+            if ( in_place )
+                planes[0] = _raw_data.ptr<unsigned char>(strip[0] - subarray[0]);
+            else {
+                strip_data.resize(length * _num_attributes);
+                for ( int j = 0; j < _num_attributes; ++j )
+                    planes[j] = strip_data.data() + j * length;
+            }
+
+            void* strip_buffers[3];
+            size_t strip_sizes[3];
+            for ( int j = 0; j < _num_attributes; ++j ) {
+                strip_buffers[j] = planes[j];
+                strip_sizes[j] = length;
+            }
+
+            try {
+                read_strip(strip_array, strip, strip_buffers, strip_sizes);
+                if ( !in_place )
+                    copy_strip(subarray, strip, planes);
+
+                // While the strip is still in cache
+                if ( _threshold_pending ) {
+                    cv::Mat rows = _raw_data.rowRange(strip[0] - subarray[0],
+                        strip[1] - subarray[0] + 1);
+                    threshold_area(rows, rows);
+                }
+            }
+            catch (...) {
+                errors.capture();
+            }
+        }
+
+        errors.finalize(strip_array);
     }
 
-    else {
-        size_t size = _img_height * _img_width;
-        unsigned char* blue_buffer = new unsigned char[size];
-        unsigned char* green_buffer = new unsigned char[size];
-        unsigned char* red_buffer = new unsigned char[size];
+    if ( errors.failed() ) {
+        _raw_data.release();
+        errors.rethrow();
+    }
+
+    _threshold_pending = false;
+}
+
+void TDBImage::read_from_tiles(int64_t* subarray)
+{
+    TDBTileCache &cache = TDBTileCache::instance();
+    std::string array_name = _group + _name;
 
-        // Size of buffers is equal to the number of attributes
-        void* buffers[] = { blue_buffer, green_buffer, red_buffer };
-        size_t buffer_sizes[] = { size, size, size };
+    // Every write adds a fragment directory to the array (and
+    // consolidation replaces them), so its modification time
+    // identifies the set of fragments the tiles were read from
+    struct stat st;
+    if ( stat(array_name.c_str(), &st) != 0 )
+        throw VCLException(TileDBNotFound, array_name + " is not a TileDB array");
 
-        int overflow = 0;
-        do {
+    std::string prefix = array_name + ":" + std::to_string(st.st_mtim.tv_sec)
+        + "." + std::to_string(st.st_mtim.tv_nsec) + ":";
+
+    // The array is only opened if the tile extents are not known or
+    // some tiles are not cached
+    TileDB_Array* tiledb_array = NULL;
+    auto open_array = [&]() {
+        Error_Check(
+            tiledb_array_init(_ctx, &tiledb_array, array_name.c_str(),
+                TILEDB_ARRAY_READ, subarray, NULL, 0),
+            "TileDB array initialization failed");
+        set_from_schema(tiledb_array);
+        _img_depth = get_cv_depth(_type);
+    };
+
+    if ( _tile_dimension.size() < 2 || _tile_dimension[0] == 0 )
+        open_array();
+
+    _raw_data.create(_img_height, _img_width, CV_MAKETYPE(_img_depth, _img_channels));
+
+    int64_t tile_height = _tile_dimension[0];
+    int64_t tile_width = _tile_dimension[1];
+
+    std::vector<std::pair<int64_t, int64_t>> missing;
+    for ( int64_t row = subarray[0] / tile_height; row <= subarray[1] / tile_height; ++row )
+        for ( int64_t col = subarray[2] / tile_width; col <= subarray[3] / tile_width; ++col ) {
+            std::string key = prefix + std::to_string(row) + "," + std::to_string(col);
+
+            cv::Mat tile;
+            if ( cache.get(key, tile) ) {
+                int64_t origin[] = { row * tile_height, col * tile_width };
+                copy_tile(subarray, origin, tile);
+            }
+            else
+                missing.push_back(std::make_pair(row, col));
+        }
+
+    if ( missing.empty() ) {
+        if ( tiledb_array != NULL )
             Error_Check(
-                tiledb_array_read(tiledb_array, buffers, buffer_sizes),
-                "TileDB read failed");
-            overflow = tiledb_array_overflow(tiledb_array, 0);
-            Error_Check(overflow, "TileDB Array Overflow error");
-        } while ( overflow == 1);
-
-        int count = 0;
-        for (int i = 0; i < size; ++i) {
-            _raw_data[count] = blue_buffer[i];
-            _raw_data[count + 1] = green_buffer[i];
-            _raw_data[count + 2] = red_buffer[i];
-            count += 3;
+                tiledb_array_finalize(tiledb_array),
+                "TileDB array failed to finalize");
+        _threshold_pending = false;
+        return;
+    }
+
+    if ( tiledb_array == NULL )
+        open_array();
+
+    int num_threads = std::min(get_num_threads(), int(missing.size()));
+
+    ParallelErrors errors;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        // Thread 0 reuses the array opened for the schema
+        TileDB_Array* tile_array = NULL;
+        if ( omp_get_thread_num() == 0 )
+            tile_array = tiledb_array;
+
+        #pragma omp for schedule(dynamic)
+        for ( int i = 0; i < int(missing.size()); ++i ) {
+            if ( errors.failed() )
+                continue;
+
+            // Tiles are read whole so that they can serve other areas,
+            // clipped to the domain of the array
+            int64_t origin[] = { missing[i].first * tile_height,
+                missing[i].second * tile_width };
+            int64_t coords[] = { origin[0],
+                std::min<int64_t>(origin[0] + tile_height, _array_dimension[0]) - 1,
+                origin[1],
+                std::min<int64_t>(origin[1] + tile_width, _array_dimension[1]) - 1 };
+
+            try {
+                cv::Mat tile = read_tile(tile_array, coords);
+                copy_tile(subarray, origin, tile);
+                cache.put(prefix + std::to_string(missing[i].first) + ","
+                    + std::to_string(missing[i].second), tile);
+            }
+            catch (...) {
+                errors.capture();
+            }
         }
 
-        Error_Check(
-            tiledb_array_finalize(tiledb_array),
-            "TileDB array failed to finalize");
+        errors.finalize(tile_array);
+    }
 
-        _tile_order = true;
+    if ( errors.failed() ) {
+        _raw_data.release();
+        errors.rethrow();
+    }
 
-        delete [] blue_buffer;
-        delete [] green_buffer;
-        delete [] red_buffer;
+    _threshold_pending = false;
+}
 
+cv::Mat TDBImage::read_tile(TileDB_Array* &tiledb_array, int64_t* tile)
+{
+    cv::Mat data(tile[1] - tile[0] + 1, tile[3] - tile[2] + 1,
+        CV_MAKETYPE(_img_depth, _img_channels));
+
+    // Within a single tile the global order is row major
+    if ( _num_attributes == 1 ) {
+        void* buffers[] = { data.data };
+        size_t buffer_sizes[] = { data.total() * data.elemSize() };
+        read_strip(tiledb_array, tile, buffers, buffer_sizes);
+        return data;
     }
+
+    size_t length = data.total() * data.elemSize1();
+    std::vector<unsigned char> tile_data(length * _num_attributes);
+
+    unsigned char* planes[3];
+    void* buffers[3];
+    size_t buffer_sizes[3];
+    for ( int j = 0; j < _num_attributes; ++j ) {
+        planes[j] = tile_data.data() + j * length;
+        buffers[j] = planes[j];
+        buffer_sizes[j] = length;
+    }
+
+    read_strip(tiledb_array, tile, buffers, buffer_sizes);
+
+    size_t row_length = data.cols * data.elemSize1();
+    for ( int row = 0; row < data.rows; ++row )
+        interleave(planes, row * row_length, data.ptr<unsigned char>(row), data.cols);
+
+    return data;
 }
 
+void TDBImage::copy_tile(const int64_t* subarray, const int64_t* origin,
+    const cv::Mat &tile)
+{
+    int64_t start_row = std::max(subarray[0], origin[0]);
+    int64_t end_row = std::min(subarray[1], origin[0] + tile.rows - 1);
+    int64_t start_column = std::max(subarray[2], origin[1]);
+    int64_t end_column = std::min(subarray[3], origin[1] + tile.cols - 1);
 
-template <class T>
-void TDBImage::reorder_buffer(T* buffer)
+    cv::Size size(end_column - start_column + 1, end_row - start_row + 1);
+
+    cv::Mat source(tile, cv::Rect(cv::Point(start_column - origin[1],
+        start_row - origin[0]), size));
+    cv::Mat target(_raw_data, cv::Rect(cv::Point(start_column - subarray[2],
+        start_row - subarray[0]), size));
+
+    // Cached tiles are shared, so they are thresholded as they are copied
+    if ( _threshold_pending )
+        threshold_area(source, target);
+    else
+        source.copyTo(target);
+}
+
+void TDBImage::visit_tiles(const TileFunction &function,
+    const std::function<void(int, int)> &row_done)
 {
-    int i,j;
-    int nRows = _array_dimension[0] / float(_tile_dimension[0]);
-    int nCols = _array_dimension[1] / float(_tile_dimension[1]);
+    if ( _img_height == 0 )
+        read_metadata();
 
-    int buffer_index = 0;
-    int full_row_tile = _img_width * _tile_dimension[0] * _img_channels;
+    std::string array_name = _group + _name;
 
-    if ( _array_dimension[1] > _img_width ) {
-        nCols = _img_width / _tile_dimension[1];
-        if ( nCols * _tile_dimension[1] < _img_width )
-            nCols += 1;
-    }
-    if ( _array_dimension[0] > _img_height ) {
-        nRows = _img_height / _tile_dimension[0];
-        if ( nRows * _tile_dimension[0] < _img_height )
-            nRows += 1;
-    }
+    TileDB_Array* tiledb_array;
+    Error_Check(
+        tiledb_array_init(_ctx, &tiledb_array, array_name.c_str(),
+            TILEDB_ARRAY_READ, NULL, NULL, 0),
+        "TileDB array initialization failed");
 
-    for ( i = 0; i < nRows; ++i ) {
-        for ( j = 0; j < nCols; ++j ) {
-            int64_t subarray[4];
-            get_tile_coordinates(subarray, i, j);
+    // The tiles are the ones find_tile_extents chose when writing
+    set_from_schema(tiledb_array);
+    _img_depth = get_cv_depth(_type);
 
-            int start = i * full_row_tile + j * _tile_dimension[1] * _img_channels;
-            buffer_index = reorder_tile(buffer, subarray, buffer_index, start);
+    int tile_height = _tile_dimension[0];
+    int tile_width = _tile_dimension[1];
+    int num_rows = (_img_height + tile_height - 1) / tile_height;
+    int num_columns = (_img_width + tile_width - 1) / tile_width;
+    int num_threads = std::min(get_num_threads(), num_columns);
+
+    ParallelErrors errors;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        // Thread 0 reuses the array opened for the schema, each thread
+        // keeps its array open across rows
+        TileDB_Array* tile_array = NULL;
+        if ( omp_get_thread_num() == 0 )
+            tile_array = tiledb_array;
+
+        for ( int row = 0; row < num_rows; ++row ) {
+            int start_row = row * tile_height;
+            int rows = std::min(tile_height, _img_height - start_row);
+
+            #pragma omp for schedule(dynamic)
+            for ( int column = 0; column < num_columns; ++column ) {
+                if ( errors.failed() )
+                    continue;
+
+                // Tiles past the image only hold padding
+                Rectangle area(column * tile_width, start_row,
+                    std::min(tile_width, _img_width - column * tile_width), rows);
+                int64_t coords[] = { area.y, area.y + area.height - 1,
+                    area.x, area.x + area.width - 1 };
+
+                try {
+                    cv::Mat tile = read_tile(tile_array, coords);
+                    if ( _threshold_pending )
+                        threshold_area(tile, tile);
+                    function(tile, area);
+                }
+                catch (...) {
+                    errors.capture();
+                }
+            }
+
+            #pragma omp single
+            {
+                if ( !errors.failed() ) {
+                    try {
+                        row_done(start_row, rows);
+                    }
+                    catch (...) {
+                        errors.capture();
+                    }
+                }
+            }
         }
+
+        errors.finalize(tile_array);
     }
+
+    errors.rethrow();
 }
 
-template void TDBImage::reorder_buffer(unsigned char* buffer);
+void TDBImage::read_strip(TileDB_Array* &tiledb_array, int64_t* strip,
+    void** buffers, size_t* buffer_sizes)
+{
+    if ( tiledb_array == NULL ) {
+        std::string array_name = _group + _name;
+        Error_Check(
+            tiledb_array_init(_ctx, &tiledb_array, array_name.c_str(),
+                TILEDB_ARRAY_READ, strip, NULL, 0),
+            "TileDB array initialization failed");
+    }
+    else {
+        Error_Check(
+            tiledb_array_reset_subarray(tiledb_array, strip),
+            "TileDB subarray reset failed");
+    }
 
-template <class T>
-int TDBImage::reorder_tile(T* buffer, int64_t* subarray, int buffer_index,
-    int start_index)
+    int overflow = 0;
+    do {
+        Error_Check(
+            tiledb_array_read(tiledb_array, buffers, buffer_sizes),
+            "TileDB read failed");
+        overflow = tiledb_array_overflow(tiledb_array, 0);
+        Error_Check(overflow, "TileDB Array Overflow error");
+    } while ( overflow == 1);
+}
+
+
+cv::Mat TDBImage::read_area(const Rectangle &rect)
+{
+    int height = _img_height;
+    int width = _img_width;
+
+    // read_from_tdb reads an area of the size of the image
+    _img_height = rect.height;
+    _img_width = rect.width;
+
+    int64_t subarray[] = { rect.y, rect.y + rect.height - 1,
+        rect.x, rect.x + rect.width - 1 };
+
+    try {
+        read_from_tdb(subarray);
+    }
+    catch ( ... ) {
+        _img_height = height;
+        _img_width = width;
+        throw;
+    }
+
+    _img_height = height;
+    _img_width = width;
+
+    cv::Mat area = _raw_data;
+    _raw_data.release();
+
+    return area;
+}
+
+Rectangle TDBImage::read_level(cv::Size size, const Rectangle &area,
+    cv::Size &level_size)
 {
-    int current_tile_height = subarray[1] - subarray[0];
-    int current_tile_width = subarray[3] - subarray[2];
+    if ( _img_height == 0 )
+        read_metadata();
 
-    int data_index;
-    int x, y;
+    // Thresholding a level is not the same as thresholding the image
+    int level = _threshold_pending ? 0 : get_level(size);
 
-    for ( x = 0; x < current_tile_height; ++x ) {
-        data_index = start_index + x * _img_width * _img_channels;
-        for ( y = 0; y < current_tile_width * _img_channels; ++y ) {
-            buffer[data_index] = T(_raw_data[buffer_index]);
-            ++data_index;
-            ++buffer_index;
+    // Only the tiles under the source pixels of the area are read
+    level_size = cv::Size(_img_width >> level, _img_height >> level);
+    Rectangle level_area = resize_source_area(area, level_size, size);
+
+    if ( level == 0 ) {
+        read(level_area);
+        return level_area;
+    }
+
+    TDBImage level_tdb(get_level_id(_group + _name, level));
+    level_tdb.set_num_threads(_num_threads);
+    level_tdb.read(level_area);
+
+    _img_height = level_tdb._img_height;
+    _img_width = level_tdb._img_width;
+    _img_size = level_tdb._img_size;
+    _raw_data = level_tdb._raw_data;
+
+    return level_area;
+}
+
+void TDBImage::copy_strip(const int64_t* subarray, const int64_t* strip,
+    unsigned char** planes)
+{
+    int64_t tile_width = _tile_dimension[1];
+    int64_t strip_height = strip[1] - strip[0] + 1;
+    size_t value_size = _raw_data.elemSize1();
+    size_t index = 0;
+
+    // The tiles of a strip follow each other, each one in row order
+    int64_t column = subarray[2];
+    while ( column <= subarray[3] ) {
+        int64_t tile_end = std::min(subarray[3],
+            (column / tile_width + 1) * tile_width - 1);
+        int width = tile_end - column + 1;
+
+        for ( int64_t row = 0; row < strip_height; ++row ) {
+            unsigned char* data = _raw_data.ptr<unsigned char>(
+                strip[0] - subarray[0] + row) + (column - subarray[2]) * _raw_data.elemSize();
+
+            if ( _num_attributes == 1 ) {
+                std::memcpy(data, planes[0] + index, width * _raw_data.elemSize());
+                index += width * _raw_data.elemSize();
+            }
+            else {
+                interleave(planes, index, data, width);
+                index += width * value_size;
+            }
         }
+
+        column = tile_end + 1;
     }
-    return buffer_index;
 }
 
-template int TDBImage::reorder_tile(unsigned char* buffer, int64_t* subarray,
-        int buffer_index, int start_index);
+void TDBImage::interleave(unsigned char** planes, size_t index,
+    unsigned char* data, int width)
+{
+    if ( _img_depth == CV_8U ) {
+        merge_channels(planes[0] + index, planes[1] + index,
+            planes[2] + index, data, width);
+    }
+    else {
+        int plane_type = CV_MAKETYPE(_img_depth, 1);
+        std::vector<cv::Mat> channels = {
+            cv::Mat(1, width, plane_type, planes[0] + index),
+            cv::Mat(1, width, plane_type, planes[1] + index),
+            cv::Mat(1, width, plane_type, planes[2] + index) };
+        cv::Mat pixels(1, width, CV_MAKETYPE(_img_depth, 3), data);
+        cv::merge(channels, pixels);
+    }
+}
 
+void TDBImage::threshold_area(const cv::Mat &source, cv::Mat &target)
+{
+    if ( _img_depth != CV_8U ) {
+        cv::threshold(source, target, _threshold, _threshold, cv::THRESH_TOZERO);
+        return;
+    }
 
-    /*  *********************** */
-    /*      MATH FUNCTIONS      */
-    /*  *********************** */
-double TDBImage::linear_interpolation(double x1, double val1, double x2,
-    double val2, double x)
+    size_t length = source.cols * source.elemSize();
+    for ( int row = 0; row < source.rows; ++row )
+        threshold_tozero(source.ptr<unsigned char>(row),
+            target.ptr<unsigned char>(row), length, _threshold);
+}
+
+void TDBImage::write_to_tdb(const std::string &array_name, const cv::Mat &data,
+    int64_t* subarray)
 {
+    TileDB_Array* image_array;
+    Error_Check(
+        tiledb_array_init(_ctx, &image_array, array_name.c_str(),
+            TILEDB_ARRAY_WRITE_SORTED_ROW, subarray, NULL, 0),
+        "TileDB array failed to initialize");
+
+    size_t row_size = size_t(data.cols) * data.elemSize();
 
-    if ( x1 == x2 )
-        return val1;
+    // Cells are appended in row order across writes, so rows that are
+    // not continuous (and the planes of three attributes) are written
+    // a strip at a time instead of being copied in full
+    if ( _num_attributes == 1 ) {
+        int strip_rows = data.isContinuous() ? data.rows : 1;
 
-    double value = val2 - val1;
-    double multiply = x - x1;
-    double divide = x2 - x1;
+        for ( int row = 0; row < data.rows; row += strip_rows ) {
+            // Size of buffers is equal to the number of attributes
+            const void* buffers[] = { data.ptr<unsigned char>(row) };
+            size_t buffer_sizes[] = { row_size * strip_rows };
 
-    return val1 + (value/divide * multiply);
+            Error_Check(
+                tiledb_array_write(image_array, buffers, buffer_sizes),
+                "TileDB write to array failed");
+        }
+    }
+    else {
+        int strip_rows = std::max(size_t(1), write_strip_size / row_size);
+        strip_rows = std::min(strip_rows, data.rows);
+
+        size_t plane_row_size = size_t(data.cols) * data.elemSize1();
+        size_t plane_size = strip_rows * plane_row_size;
+        std::vector<unsigned char> planes(3 * plane_size);
+        unsigned char* blue = planes.data();
+        unsigned char* green = blue + plane_size;
+        unsigned char* red = green + plane_size;
+
+        int plane_type = CV_MAKETYPE(data.depth(), 1);
+
+        for ( int row = 0; row < data.rows; row += strip_rows ) {
+            int rows = std::min(strip_rows, data.rows - row);
+
+            for ( int i = 0; i < rows; ++i ) {
+                size_t offset = i * plane_row_size;
+                if ( data.depth() == CV_8U )
+                    split_channels(data.ptr<unsigned char>(row + i),
+                        blue + offset, green + offset, red + offset, data.cols);
+                else {
+                    std::vector<cv::Mat> channels = {
+                        cv::Mat(1, data.cols, plane_type, blue + offset),
+                        cv::Mat(1, data.cols, plane_type, green + offset),
+                        cv::Mat(1, data.cols, plane_type, red + offset) };
+                    cv::split(data.row(row + i), channels);
+                }
+            }
+
+            // Size of buffers is equal to the number of attributes
+            size_t size = rows * plane_row_size;
+            const void* buffers[] = { blue, green, red };
+            size_t buffer_sizes[] = { size, size, size };
+
+            Error_Check(
+                tiledb_array_write(image_array, buffers, buffer_sizes),
+                "TileDB write to array failed");
+        }
+    }
+
+    Error_Check(
+        tiledb_array_finalize(image_array),
+        "TileDB array failed to finalize");
 }
@@ -32,6 +32,9 @@
 
 #pragma once
 
+#include <functional>
+#include <string>
+
 #include <opencv2/core.hpp>
 
 #include <tiledb.h>
@@ -49,6 +52,29 @@ namespace VCL {
 
     class TDBImage : public TDBObject {
 
+    public:
+        /**
+         *  Called with the pixels of a tile and the area of the image
+         *    it covers. Called from several threads at once
+         */
+        typedef std::function<void(const cv::Mat&, const Rectangle&)>
+            TileFunction;
+
+        /**
+         *  Called with the pixels of a tile and the area of the image
+         *    it covers, returns the result for that area (of any type,
+         *    as long as it is the same for every tile). Called from
+         *    several threads at once
+         */
+        typedef std::function<cv::Mat(const cv::Mat&, const Rectangle&)>
+            TileMapFunction;
+
+        /**
+         *  Called with a strip of rows of a result and the first row of
+         *    the result it starts at, in order from the top
+         */
+        typedef std::function<void(const cv::Mat&, int)> StripFunction;
+
     /*  *********************** */
     /*        VARIABLES         */
     /*  *********************** */
@@ -57,13 +83,24 @@ namespace VCL {
         int _img_height, _img_width, _img_channels;
         int _img_size;
 
-        // threshold value
+        // OpenCV depth of the pixel values (CV_8U, CV_16U, CV_32F, etc)
+        int _img_depth;
+
+        // threshold value, applied to the data as it is read if pending
         int _threshold;
+        bool _threshold_pending;
+
+        // Number of downsampled levels (1/2, 1/4, ...) stored next to
+        // the image
+        int _pyramid_levels;
 
-        bool _tile_order;
+        // raw data of the image, in row order (shared between copies,
+        // operations replace it instead of modifying it)
+        cv::Mat _raw_data;
 
-        // raw data of the image
-        unsigned char* _raw_data;
+        // Array being written area by area, empty if no write is in
+        // progress
+        std::string _write_array;
 
     public:
     /*  *********************** */
@@ -103,6 +140,31 @@ namespace VCL {
          */
         void operator=(TDBImage &tdb);
 
+        /**
+         *  Creates a TDBImage object by taking over the data and TileDB
+         *    context of an existing TDBImage, without copying
+         *
+         *  @param tdb  The TDBImage to move from, left empty
+         */
+        TDBImage(TDBImage &&tdb) noexcept;
+
+        /**
+         *  Sets a TDBImage object equal to another TDBImage without
+         *    reading its data. Data that has been read is shared,
+         *    otherwise it is read from TileDB when it is needed
+         *
+         *  @param tdb  A reference to an existing TDBImage
+         */
+        void share(const TDBImage &tdb);
+
+        /**
+         *  Sets a TDBImage object to the data and TileDB context of
+         *    another TDBImage, without copying
+         *
+         *  @param tdb  The TDBImage to move from
+         *  @return The current TDBImage
+         */
+        TDBImage& operator=(TDBImage &&tdb) noexcept;
 
         ~TDBImage();
 
@@ -140,7 +202,32 @@ namespace VCL {
         int get_image_channels();
 
         /**
-         *  Gets an OpenCV Mat that contains the image data
+         *  Gets the OpenCV type of the image, which is stored natively
+         *    as the TileDB type of the attributes
+         *
+         *  @return The OpenCV type (CV_8UC3, CV_16UC1, CV_32FC1, etc)
+         */
+        int get_image_type();
+
+        /**
+         *  Gets the number of downsampled levels stored with the image
+         *
+         *  @return The number of pyramid levels, 0 if only the full
+         *    resolution image is stored
+         */
+        int get_pyramid_levels();
+
+        /**
+         *  Gets the number of rows in a tile of the stored image. Rows
+         *    of tiles are the unit that reads of areas are split into
+         *
+         *  @return The height of a tile
+         */
+        int get_tile_height();
+
+        /**
+         *  Gets an OpenCV Mat that contains the image data. The Mat
+         *    shares the data of the TDBImage, no copy is made
          *
          *  @return An OpenCV Mat
          */
@@ -150,7 +237,7 @@ namespace VCL {
          *  Gets the raw data from the TDBImage
          *
          *  @param  buffer  A buffer (of any type) that will contain the raw
-         *     data when the function ends
+         *     data when the function ends, converted from the image type
          *  @param  buffer_size  The length of buffer (not in bytes)
          */
         template <class T> void get_buffer(T* buffer, int buffer_size);
@@ -169,6 +256,16 @@ namespace VCL {
          */
         void set_image_properties(int height, int width, int channels);
 
+        /**
+         *  Sets the number of downsampled levels to store when writing
+         *    the image. Level n is 1/2^n of the full size and is stored as
+         *    a sibling array in the same TileDB group. The number of levels
+         *    is capped so the smallest level is at least one pixel
+         *
+         *  @param levels  The number of pyramid levels, 0 for none
+         */
+        void set_pyramid_levels(int levels);
+
 
     /*  *********************** */
     /*    TDBIMAGE INTERACTION  */
@@ -192,6 +289,40 @@ namespace VCL {
          */
         void write(const cv::Mat &cv_img, bool metadata = true);
 
+        /**
+         *  Starts writing an image to the location specified by the
+         *    existing TDBImage path variables one area at a time, so
+         *    the whole image never has to be in memory
+         *
+         *  @param  height  The number of rows in the image
+         *  @param  width  The number of columns in the image
+         *  @param  type  The OpenCV type of the image (CV_8UC3, etc)
+         *  @param  metadata  A flag indicating whether the metadata
+         *    should be stored in TileDB or not. Defaults to true
+         *  @see write_area, end_write
+         */
+        void begin_write(int height, int width, int type,
+            bool metadata = true);
+
+        /**
+         *  Writes an area of the image started with begin_write as a
+         *    new TileDB fragment. Areas spanning whole rows of tiles
+         *    keep the number of fragments (and reads) small
+         *
+         *  @param  area  The OpenCV Mat containing the area data
+         *  @param  row  The row of the image where the area starts
+         *  @param  column  The column of the image where the area starts
+         */
+        void write_area(const cv::Mat &area, int row, int column);
+
+        /**
+         *  Finishes the write started with begin_write
+         *
+         *  @param  consolidate  A flag indicating whether the fragments
+         *    written should be merged into one. Defaults to false
+         */
+        void end_write(bool consolidate = false);
+
         /**
          *  Reads the raw data from the location specified by the existing
          *    TDBImage path variables
@@ -209,9 +340,22 @@ namespace VCL {
          */
         void read(const Rectangle &rect);
 
+        /**
+         *  Crops the image to the area specified in the Rectangle. If
+         *    no data has been read yet, only that area is read
+         *
+         *  @param rect  A Rectangle structure containing the coordinates
+         *    and size of the area to keep (starting x coordinate,
+         *    starting y coordinate, height, width)
+         *  @see  Image.h for more details on Rectangle
+         */
+        void crop(const Rectangle &rect);
+
         /**
          *  Resizes the image to the height and width specified in
-         *    the Rectangle using bilinear interpolation
+         *    the Rectangle using bilinear interpolation. If no data has
+         *    been read yet, the smallest pyramid level at least as large
+         *    as the target is read instead of the full image
          *
          *  @param rect  A Rectangle structure containing height and
          *    width to resize the image to
@@ -219,15 +363,88 @@ namespace VCL {
          */
         void resize(const Rectangle &rect);
 
+        /**
+         *  Resizes the image to the height and width specified in the
+         *    first Rectangle and keeps only the area specified in the
+         *    second one. If no data has been read yet, only the tiles
+         *    that the area is interpolated from are read
+         *
+         *  @param rect  A Rectangle structure containing height and
+         *    width to resize the image to
+         *  @param area  A Rectangle structure containing the area of
+         *    the resized image to keep
+         *  @see  Image.h for more details on Rectangle
+         */
+        void resize(const Rectangle &rect, const Rectangle &area);
+
+        /**
+         *  Resizes the stored image to the given size a strip of rows at
+         *    a time, from the smallest pyramid level at least that size.
+         *    Only the rows of tiles of the source under the current strip
+         *    and up to four rows read ahead are in memory, so neither
+         *    image has to fit. 8 bit images only
+         *
+         *  @param size  The size of the resized image
+         *  @param function  The function to call with each strip
+         */
+        void resize_strips(cv::Size size, const StripFunction &function);
+
+        /**
+         *  Writes the stored image resized to the given size to a new TDB
+         *    image, without reading the whole image
+         *
+         *  @param image_id  The full path to the new TDB image
+         *  @param size  The size of the resized image
+         *  @param metadata  Whether to store the metadata of the new image
+         *  @see resize_strips
+         */
+        void resize_to(const std::string &image_id, cv::Size size,
+            bool metadata = true);
+
         /**
          *  Sets pixel values less than or equal to the specified
-         *    value to zero
+         *    value to zero. If no data is loaded yet, the threshold is
+         *    applied to each strip or tile as it is read instead of in
+         *    another pass over the image
          *
          *  @param value  The threshold under which pixel values should
          *    be set to zero
          */
         void threshold(int value);
 
+        /**
+         *  Calls a function on every tile of the stored image, reading
+         *    the tiles of a row in parallel. Only the tiles being
+         *    processed are in memory, so the image does not have to fit
+         *
+         *  @param function  The function to call on each tile
+         */
+        void for_each_tile(const TileFunction &function);
+
+        /**
+         *  Writes the result of a function on every tile of the stored
+         *    image to a new TDB image with the same tiling, a row of
+         *    tiles at a time. Only one row of tiles is in memory, so the
+         *    image does not have to fit
+         *
+         *  @param image_id  The full path to the new TDB image
+         *  @param function  The function giving the result of each tile
+         *  @param metadata  Whether to store the metadata of the new image
+         */
+        void map_tiles(const std::string &image_id,
+            const TileMapFunction &function, bool metadata = true);
+
+        /**
+         *  Writes the stored image, with pixel values less than or
+         *    equal to the specified value set to zero, to a new TDB
+         *    image tile by tile
+         *
+         *  @param image_id  The full path to the new TDB image
+         *  @param value  The threshold under which pixel values should
+         *    be set to zero
+         */
+        void threshold_tiles(const std::string &image_id, int value);
+
         /**
          *  Checks to see if the TDBImage is pointing to data
          *
@@ -257,57 +474,45 @@ namespace VCL {
         std::string get_parent_dir(const std::string &filename) const;
 
         /**
-         *  Gets the coordinates in an array given the current tile
+         *  Gets the object id of a pyramid level of an image
          *
-         *  @param  subarray  An array in which the coordinates will be stored
-         *  @param  current_column_tile  The current column tile
-         *  @param  current_row_tile  The current row tile
+         *  @param  image_id  The object id of the full resolution image
+         *  @param  level  The pyramid level
+         *  @return  The object id of the level
          */
-        void get_tile_coordinates(int64_t* subarray, int current_column_tile,
-            int current_row_tile);
+        std::string get_level_id(const std::string &image_id, int level) const;
 
-       /**
-         *  Used for resizing, gets the value of the calculated index
+        /**
+         *  Gets the smallest pyramid level that is at least the given size
          *
-         *  @param  image_buffer  A buffer to store the resized image in
-         *  @param  index  The current index into the image_buffer
-         *  @param  scale_r  The row to be used to calculate the index into
-         *    the raw data
-         *  @param  scale_c  The column to be used to calculate the index into
-         *    the raw data
+         *  @param  size  The size the image is resized to
+         *  @return  The pyramid level, 0 for the full resolution image
          */
-        void get_index_value(unsigned char* image_buffer, int index,
-            float scale_r, float scale_c);
+        int get_level(cv::Size size) const;
 
-       /**
-         *  Used for resizing, calculates the index in the raw data where the
-         *    value found at [row, column] in the image can be found
+        /**
+         *  Gets the TileDB type that stores values of an OpenCV depth
          *
-         *  @param  row  The row index
-         *  @param  column  The column index
-         *  @return  The index in the raw data where [row, column] is
+         *  @param  depth  The OpenCV depth (CV_8U, CV_32F, etc)
+         *  @return  The TileDB type (TILEDB_CHAR, TILEDB_FLOAT32, etc)
          */
-        int get_index(int row, int column) const;
+        int get_tiledb_type(int depth) const;
 
-       /**
-         *  Used for resizing, calculates the height of the current tile (used
-         *    when the image height is not the same as the array height)
+        /**
+         *  Gets the properties stored in the metadata of the image
+         *    (dimensions, type, pyramid levels, tiling and compression)
          *
-         *  @param  row  The row index
-         *  @param  number_tiles  The number of row tiles in the image
-         *  @return  The height of the current tile
+         *  @return  The property values, in the order they are stored
          */
-        int get_tile_height(int row, int number_tiles) const;
+        std::vector<int64_t> get_properties() const;
 
-       /**
-         *  Used for resizing, calculates the width of the current tile (used
-         *    when the image width is not the same as the array width)
+        /**
+         *  Gets the OpenCV depth of the values of a TileDB type
          *
-         *  @param  column  The column index
-         *  @param  number_tiles  The number of column tiles in the image
-         *  @return  The width of the current tile
+         *  @param  type  The TileDB type (TILEDB_CHAR, TILEDB_FLOAT32, etc)
+         *  @return  The OpenCV depth (CV_8U, CV_32F, etc)
          */
-        int get_tile_width(int column, int number_tiles) const;
+        int get_cv_depth(int type) const;
 
 
     /*  *********************** */
@@ -319,6 +524,14 @@ namespace VCL {
          */
         void set_default_dimensions();
 
+        /**
+         *  Sets the dimensions, type and pyramid levels of the image
+         *    from the properties stored in its metadata
+         *
+         *  @param  properties  The property values, as stored
+         */
+        void set_properties(const std::vector<int64_t> &properties);
+
         /**
          *  Sets the names of the attributes to the default of
          *    "pixel" if one attribute and "green", "blue", and
@@ -358,15 +571,41 @@ namespace VCL {
          */
         int array_setup(const std::string &image_id, bool metadata);
 
+        /**
+         *  Writes the downsampled levels of the image data, each one
+         *    halving the previous level
+         *
+         *  @param  image_id  The object id of the full resolution image
+         */
+        void write_pyramid(const std::string &image_id);
+
 
     /*  *********************** */
     /*   METADATA INTERACTION   */
     /*  *********************** */
         /**
-         *  Reads the metadata at the existing TDBImage path variables
+         *  Reads the metadata at the existing TDBImage path variables,
+         *    or gets it from the TDBMetadataCache if it was already read
+         *    or written by the process
          */
         void read_metadata();
 
+        /**
+         *  Reads all the properties of the image with a single read
+         *
+         *  @param  md_name  The full path to the properties metadata
+         *  @return  The property values, in the order they are stored
+         */
+        std::vector<int64_t> read_properties(const std::string &md_name);
+
+        /**
+         *  Reads the properties of an image stored with one metadata
+         *    key per property
+         *
+         *  @return  The property values, in the order they are stored
+         */
+        std::vector<int64_t> read_legacy_metadata();
+
 
     /*  *********************** */
     /*     DATA MANIPULATION    */
@@ -374,7 +613,8 @@ namespace VCL {
 
         /**
          *  Reads the specified subarray from the array at the existing
-         *    TDBImage path variables (can be the full array)
+         *    TDBImage path variables (can be the full array). The subarray
+         *    is split into strips of tile rows which are read in parallel
          *
          *  @param  subarray  An array of the coordinates of the subarray
          *    to read
@@ -382,40 +622,126 @@ namespace VCL {
         void read_from_tdb(int64_t* subarray);
 
         /**
-         *  Reorders the raw data buffer into image order and
-         *    casts as the specified type
+         *  Reads the specified subarray from the tiles of the array kept
+         *    in the TDBTileCache, reading the tiles that are not cached
+         *    in full (in parallel) and adding them to the cache
          *
-         *  @param  buffer  The buffer to store the image order data in
+         *  @param  subarray  An array of the coordinates of the subarray
+         *    to read
          */
-        template <class T> void reorder_buffer(T* buffer);
+        void read_from_tiles(int64_t* subarray);
 
         /**
-         *  Reorders a tile into image order and casts as the
-         *    specified type
+         *  Reads a single tile of the array, interleaving the attributes
+         *    if there is more than one
          *
-         *  @param  buffer  The buffer to store the image order data in
-         *  @param  subarray  The coordinates of the current tile
-         *  @param  tile  The current tile number (in row order)
-         *  @param  start_index  The current index into the raw data buffer
-         *  @return  The current index into the image order buffer
+         *  @param  tiledb_array  The array to read from, initialized if NULL
+         *  @param  tile  The coordinates of the tile, within the domain
+         *  @return  The pixels of the tile
          */
-        template <class T> int reorder_tile(T* buffer, int64_t* subarray,
-            int tile, int start_index);
+        cv::Mat read_tile(TileDB_Array* &tiledb_array, int64_t* tile);
+
+        /**
+         *  Copies the part of a tile within the subarray being read
+         *    into the image
+         *
+         *  @param  subarray  The coordinates of the subarray being read
+         *  @param  origin  The row and column of the first pixel of the tile
+         *  @param  tile  The pixels of the tile
+         */
+        void copy_tile(const int64_t* subarray, const int64_t* origin,
+            const cv::Mat &tile);
+
+        /**
+         *  Reads the tiles of the stored image a row at a time, the tiles
+         *    of each row in parallel, calling a function on each one and
+         *    another once a row is done
+         *
+         *  @param  function  The function to call on each tile
+         *  @param  row_done  The function to call, from a single thread,
+         *    with the first row of pixels and the number of rows of each
+         *    row of tiles once all its tiles were processed
+         */
+        void visit_tiles(const TileFunction &function,
+            const std::function<void(int, int)> &row_done);
+
+        /**
+         *  Reads the part of the smallest pyramid level at least the
+         *    given size (or of the full image if there is no such level)
+         *    that an area of the image resized to that size needs
+         *
+         *  @param  size  The size the image is resized to
+         *  @param  area  The area of the resized image that is needed
+         *  @param  level_size  Set to the full size of the level read
+         *  @return  The area of the level that was read
+         */
+        Rectangle read_level(cv::Size size, const Rectangle &area,
+            cv::Size &level_size);
+
+        /**
+         *  Reads an area of the stored image without keeping it or
+         *    changing the size of the TDBImage, so that the same
+         *    TDBImage can read one area after another
+         *
+         *  @param  rect  The area to read, within the image
+         *  @return  The pixels of the area
+         */
+        cv::Mat read_area(const Rectangle &rect);
+
+        /**
+         *  Reads one strip of the array into the given buffers, opening
+         *    the array if needed or moving an open array to the strip
+         *
+         *  @param  tiledb_array  The array to read from, initialized if NULL
+         *  @param  strip  The coordinates of the strip to read
+         *  @param  buffers  One buffer per attribute to read into
+         *  @param  buffer_sizes  The size in bytes of each buffer
+         */
+        void read_strip(TileDB_Array* &tiledb_array, int64_t* strip,
+            void** buffers, size_t* buffer_sizes);
+
+        /**
+         *  Copies a strip read in global order into the image,
+         *    interleaving the attributes if there is more than one
+         *
+         *  @param  subarray  The coordinates of the subarray being read
+         *  @param  strip  The coordinates of the strip within the subarray
+         *  @param  planes  One buffer per attribute holding the strip
+         */
+        void copy_strip(const int64_t* subarray, const int64_t* strip,
+            unsigned char** planes);
+
+        /**
+         *  Interleaves one row of three attribute planes into pixels
+         *
+         *  @param  planes  One buffer per attribute
+         *  @param  index  The offset in bytes of the row in each buffer
+         *  @param  data  The pixels to write to
+         *  @param  width  The number of pixels in the row
+         */
+        void interleave(unsigned char** planes, size_t index,
+            unsigned char* data, int width);
+
+        /**
+         *  Applies the pending threshold to pixels just read
+         *
+         *  @param  source  The pixels to threshold
+         *  @param  target  The pixels to write to, of the same size and
+         *    type (can be source)
+         */
+        void threshold_area(const cv::Mat &source, cv::Mat &target);
 
-    /*  *********************** */
-    /*      MATH FUNCTIONS      */
-    /*  *********************** */
         /**
-         *  Linearly interpolates two data points
+         *  Writes an image or an area of one to an array as a single
+         *    fragment, converting at most a strip of rows to planes at
+         *    a time if there is more than one attribute
          *
-         *  @param  x1  The first reference point
-         *  @param  val1  The value at the first reference point
-         *  @param  x2  The second reference point
-         *  @param  val2  The value at the second reference point
-         *  @param  x  The desired point
-         *  @return  The value at the desired point
+         *  @param  array_name  The full path to the TileDB array
+         *  @param  data  The OpenCV Mat containing the data
+         *  @param  subarray  The coordinates of the area being written,
+         *    NULL for the whole array
          */
-        double linear_interpolation(double x1, double val1, double x2,
-            double val2, double x);
+        void write_to_tdb(const std::string &array_name, const cv::Mat &data,
+            int64_t* subarray);
     };
 };
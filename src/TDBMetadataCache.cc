@@ -0,0 +1,93 @@
+/**
+ * @file   TDBMetadataCache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the C++ API for TDBMetadataCache
+ */
+
+#include "TDBMetadataCache.h"
+
+using namespace VCL;
+
+    /*  *********************** */
+    /*        CONSTRUCTORS      */
+    /*  *********************** */
+
+TDBMetadataCache& TDBMetadataCache::instance()
+{
+    static TDBMetadataCache cache;
+    return cache;
+}
+
+
+    /*  *********************** */
+    /*        GET FUNCTIONS     */
+    /*  *********************** */
+
+bool TDBMetadataCache::get(const std::string &object_id,
+    std::vector<int64_t> &properties)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+
+    auto entry = _properties.find(object_id);
+    if ( entry == _properties.end() )
+        return false;
+
+    properties = entry->second;
+    return true;
+}
+
+int TDBMetadataCache::get_num_entries()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _properties.size();
+}
+
+
+    /*  *********************** */
+    /*        SET FUNCTIONS     */
+    /*  *********************** */
+
+void TDBMetadataCache::set(const std::string &object_id,
+    const std::vector<int64_t> &properties)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _properties[object_id] = properties;
+}
+
+void TDBMetadataCache::erase(const std::string &object_id)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _properties.erase(object_id);
+}
+
+void TDBMetadataCache::clear()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _properties.clear();
+}
@@ -29,6 +29,7 @@
 
 #include <stddef.h>
 #include <string>
+#include <algorithm>
 
 #include <iostream>
 
@@ -36,22 +37,35 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <omp.h>
 
 #include <tiledb.h>
 #include "TDBObject.h"
+#include "TDBContextPool.h"
+#include "TDBMetadataCache.h"
 #include "Exception.h"
 
 using namespace VCL;
 
+// Square tile lengths considered when tiling for a read pattern, at
+// most a few MB per tile so a tile stays in the last level cache
+static const int min_tile_length = 32;
+static const int max_tile_length = 1024;
+
+// Length of the regions read if REGION_READS is given no size
+static const int default_region_length = 256;
+
+// Fixed cost of reading a tile (a seek, decompressor setup and the
+// tile bookkeeping), in cells
+static const double tile_cost = 32768;
+
     /*  *********************** */
     /*        CONSTRUCTORS      */
     /*  *********************** */
 
 TDBObject::TDBObject()
 {
-    Error_Check(
-        tiledb_ctx_init(&_ctx, NULL),
-        "TileDB context initialization failed");
+    _ctx = TDBContextPool::instance().acquire();
 
     _workspace = "";
     _group = "";
@@ -62,13 +76,15 @@ TDBObject::TDBObject()
     _attributes.push_back("value");
     _compressed = CompressionType::LZ4;
     _min_tile_dimension = 4;
+    _tiling = TilingPolicy::FACTOR;
+    _tiling_size = 0;
+    _num_threads = 0;
+    _type = TILEDB_CHAR;
 }
 
 TDBObject::TDBObject(const std::string &image_id)
 {
-    Error_Check(
-        tiledb_ctx_init(&_ctx, NULL),
-        "TileDB context initialization failed");
+    _ctx = TDBContextPool::instance().acquire();
 
     size_t pos = get_path_delimiter(image_id);
 
@@ -81,13 +97,15 @@ TDBObject::TDBObject(const std::string &image_id)
     _attributes.push_back("value");
     _compressed = CompressionType::LZ4;
     _min_tile_dimension = 4;
+    _tiling = TilingPolicy::FACTOR;
+    _tiling_size = 0;
+    _num_threads = 0;
+    _type = TILEDB_CHAR;
 }
 
 TDBObject::TDBObject(const TDBObject &tdb)
 {
-    Error_Check(
-        tiledb_ctx_init(&_ctx, NULL),
-        "TileDB context initialization failed");
+    _ctx = TDBContextPool::instance().acquire();
 
     set_equal(tdb);
 }
@@ -95,12 +113,9 @@ TDBObject::TDBObject(const TDBObject &tdb)
 
 TDBObject& TDBObject::operator=(const TDBObject &tdb)
 {
-    Error_Check(
-        tiledb_ctx_finalize(_ctx),
-        "TileDB context finalization failed");
-    Error_Check(
-        tiledb_ctx_init(&_ctx, NULL),
-        "TileDB context initialization failed");
+    // The context comes from the pool, so it is kept as is
+    if ( _ctx == NULL )
+        _ctx = TDBContextPool::instance().acquire();
 
     reset_arrays();
 
@@ -109,6 +124,53 @@ TDBObject& TDBObject::operator=(const TDBObject &tdb)
     return *this;
 }
 
+TDBObject::TDBObject(TDBObject &&tdb) noexcept
+{
+    _ctx = NULL;
+    _num_dimensions = 0;
+    _num_attributes = 0;
+    _compressed = CompressionType::LZ4;
+    _min_tile_dimension = 4;
+    _tiling = TilingPolicy::FACTOR;
+    _tiling_size = 0;
+    _num_threads = 0;
+    _type = TILEDB_CHAR;
+
+    swap_equal(tdb);
+}
+
+TDBObject& TDBObject::operator=(TDBObject &&tdb) noexcept
+{
+    swap_equal(tdb);
+
+    return *this;
+}
+
+void TDBObject::swap_equal(TDBObject &tdb) noexcept
+{
+    std::swap(_workspace, tdb._workspace);
+    std::swap(_group, tdb._group);
+    std::swap(_name, tdb._name);
+
+    std::swap(_num_attributes, tdb._num_attributes);
+    std::swap(_attributes, tdb._attributes);
+
+    std::swap(_num_dimensions, tdb._num_dimensions);
+    std::swap(_dimension_names, tdb._dimension_names);
+    std::swap(_dimension_values, tdb._dimension_values);
+
+    std::swap(_compressed, tdb._compressed);
+    std::swap(_min_tile_dimension, tdb._min_tile_dimension);
+    std::swap(_tiling, tdb._tiling);
+    std::swap(_tiling_size, tdb._tiling_size);
+    std::swap(_num_threads, tdb._num_threads);
+    std::swap(_type, tdb._type);
+    std::swap(_array_dimension, tdb._array_dimension);
+    std::swap(_tile_dimension, tdb._tile_dimension);
+
+    std::swap(_ctx, tdb._ctx);
+}
+
 void TDBObject::set_equal(const TDBObject &tdb)
 {
     _workspace = tdb._workspace;
@@ -129,6 +191,10 @@ void TDBObject::set_equal(const TDBObject &tdb)
 
     _compressed = tdb._compressed;
     _min_tile_dimension = tdb._min_tile_dimension;
+    _tiling = tdb._tiling;
+    _tiling_size = tdb._tiling_size;
+    _num_threads = tdb._num_threads;
+    _type = tdb._type;
     _array_dimension = tdb._array_dimension;
     _tile_dimension = tdb._tile_dimension;
 }
@@ -136,9 +202,10 @@ void TDBObject::set_equal(const TDBObject &tdb)
 TDBObject::~TDBObject()
 {
     reset_arrays();
-    Error_Check(
-        tiledb_ctx_finalize(_ctx),
-        "TileDB context finalization failed");
+
+    // A moved from object has no context
+    if ( _ctx != NULL )
+        TDBContextPool::instance().release(_ctx);
 }
 
 void TDBObject::reset_arrays()
@@ -154,6 +221,8 @@ void TDBObject::reset_arrays()
 void TDBObject::delete_object()
 {
     std::string object_id = _group + _name;
+    TDBMetadataCache::instance().erase(object_id);
+
     Error_Check(
         tiledb_delete(_ctx, object_id.c_str()),
         "TileDB delete failed");
@@ -168,6 +237,13 @@ std::string TDBObject::get_image_id() const
     return _group + _name;
 }
 
+int TDBObject::get_num_threads() const
+{
+    if ( _num_threads > 0 )
+        return _num_threads;
+    return omp_get_max_threads();
+}
+
 
     /*  *********************** */
     /*        SET FUNCTIONS     */
@@ -202,6 +278,24 @@ void TDBObject::set_minimum(int dimension)
     _min_tile_dimension = dimension;
 }
 
+void TDBObject::set_tiling(TilingPolicy policy, int size)
+{
+    if ( size < 0 )
+        throw VCLException(UnsupportedOperation, "Tiling size cannot be negative");
+    if ( policy == TilingPolicy::FIXED && size == 0 )
+        throw VCLException(UnsupportedOperation, "Fixed tiling needs a tile size");
+
+    _tiling = policy;
+    _tiling_size = size;
+}
+
+void TDBObject::set_num_threads(int threads)
+{
+    if ( threads < 0 )
+        throw VCLException(UnsupportedOperation, "Number of threads cannot be negative");
+    _num_threads = threads;
+}
+
 void TDBObject::set_num_attributes(int num)
 {
     _num_attributes = num;
@@ -375,10 +469,13 @@ void TDBObject::set_from_schema(TileDB_Array* tiledb_array)
 
     _num_attributes = schema.attribute_num_;
     _num_dimensions = schema.dim_num_;
+    _type = schema.types_[0];
 
     int64_t* tiles = (int64_t*) schema.tile_extents_;
     int64_t* domain = (int64_t*) schema.domain_;
 
+    _tile_dimension.clear();
+    _array_dimension.clear();
     for (int i = 0; i < _num_dimensions; ++i)
         _tile_dimension.push_back(tiles[i]);
     for (int i = 0; i < _num_dimensions*2; i+=2)
@@ -395,12 +492,13 @@ void TDBObject::set_from_schema(TileDB_Array* tiledb_array)
     /*  *********************** */
 
 void TDBObject::write_metadata(const std::string &metadata, int64_t *buffer,
-    char* buffer_var_keys, size_t* buffer_keys, size_t var_keys_size)
+    char* buffer_var_keys, size_t* buffer_keys, size_t var_keys_size,
+    int num_keys, int cell_val_num)
 {
     const char* metadata_name = metadata.c_str();
     const char* attributes[] = { "dimensions" };
     const int capacity = 4;
-    const int cell_val_num[] = { 1 };
+    const int cell_val_nums[] = { cell_val_num };
 
     const int compression[] = {int(_compressed), TILEDB_NO_COMPRESSION};
     const int types[] = { TILEDB_INT64 };
@@ -408,7 +506,7 @@ void TDBObject::write_metadata(const std::string &metadata, int64_t *buffer,
     TileDB_MetadataSchema metadata_schema;
     Error_Check(
         tiledb_metadata_set_schema(&metadata_schema, metadata_name,
-            attributes, 1, capacity, cell_val_num, compression, types),
+            attributes, 1, capacity, cell_val_nums, compression, types),
         "TileDB metadata schema setup failed");
     if ( tiledb_dir_type(_ctx, metadata_name) != TILEDB_METADATA ) {
         Error_Check(
@@ -426,11 +524,9 @@ void TDBObject::write_metadata(const std::string &metadata, int64_t *buffer,
             TILEDB_METADATA_WRITE, NULL, 0),
         "TileDB metadata initialization failed");
 
-    int size = _num_dimensions + 1;
-
     const void* buffers[] = { buffer, buffer_keys, buffer_var_keys };
-    size_t buffer_sizes[] = { sizeof(buffer) * size,
-        sizeof(buffer_keys) * size, var_keys_size };
+    size_t buffer_sizes[] = { sizeof(int64_t) * num_keys * cell_val_num,
+        sizeof(size_t) * num_keys, var_keys_size };
 
     Error_Check(
         tiledb_metadata_write(tiledb_metadata, buffer_var_keys,
@@ -446,19 +542,48 @@ void TDBObject::find_tile_extents()
 {
     _array_dimension.clear();
     _tile_dimension.clear();
-    for (int x = 0; x < _num_dimensions; ++x) {
-        int dimension = _dimension_values[x];
-        int num_tiles = 0;
 
-        int gf_dimension = greatest_factor(dimension);
-        
-        while ( gf_dimension == 1 ) {
-            dimension = dimension + 1;
-            gf_dimension = greatest_factor(dimension);
+    if ( _tiling == TilingPolicy::FACTOR ) {
+        for (int x = 0; x < _num_dimensions; ++x) {
+            int dimension = _dimension_values[x];
+
+            int gf_dimension = greatest_factor(dimension);
+
+            while ( gf_dimension == 1 ) {
+                dimension = dimension + 1;
+                gf_dimension = greatest_factor(dimension);
+            }
+
+            _array_dimension.push_back(dimension);
+            _tile_dimension.push_back(gf_dimension);
+        }
+        return;
+    }
+
+    int tile = _tiling_size;
+
+    if ( _tiling != TilingPolicy::FIXED ) {
+        // Powers of two keep tiles aligned with cache lines and pages,
+        // ties go to the larger tiles
+        tile = 0;
+        double best_cost = 0;
+        for ( int candidate = min_tile_length; candidate <= max_tile_length;
+                candidate *= 2 ) {
+            double cost = tiling_cost(candidate);
+            if ( tile == 0 || cost <= best_cost ) {
+                best_cost = cost;
+                tile = candidate;
+            }
         }
+    }
+
+    for (int x = 0; x < _num_dimensions; ++x) {
+        int dimension = _dimension_values[x];
+        int extent = std::min(tile, dimension);
+        int num_tiles = (dimension + extent - 1) / extent;
 
-        _array_dimension.push_back(dimension);
-        _tile_dimension.push_back(gf_dimension);
+        _array_dimension.push_back(num_tiles * extent);
+        _tile_dimension.push_back(extent);
     }
 }
 
@@ -469,10 +594,40 @@ void TDBObject::find_tile_extents()
 void TDBObject::set_types(int* types)
 {
     for ( int i = 0; i < _num_attributes; ++i ){
-        types[i] = TILEDB_CHAR;
+        types[i] = _type;
     }
 }
 
+double TDBObject::tiling_cost(int tile)
+{
+    int region = _tiling_size > 0 ? _tiling_size : default_region_length;
+
+    double cells = 1;
+    double tiles = 1;
+
+    for (int x = 0; x < _num_dimensions; ++x) {
+        int dimension = _dimension_values[x];
+        int extent = std::min(tile, dimension);
+        int num_tiles = (dimension + extent - 1) / extent;
+
+        if ( _tiling == TilingPolicy::REGION_READS ) {
+            // A region of length r at a random offset spans
+            // (r - 1) / extent + 1 tiles on average
+            int length = std::min(region, dimension);
+            double spanned = std::min(double(num_tiles),
+                double(length - 1) / extent + 1);
+            cells *= spanned * extent;
+            tiles *= spanned;
+        }
+        else {
+            cells *= double(num_tiles) * extent;
+            tiles *= num_tiles;
+        }
+    }
+
+    return cells + tile_cost * tiles;
+}
+
 int TDBObject::greatest_factor(int a)
 {
     int b = a;
@@ -75,11 +75,22 @@ namespace VCL {
         int _num_attributes;
         std::vector<std::string> _attributes;
 
+        // TileDB type of the attribute values (TILEDB_CHAR, etc)
+        int _type;
+
         // Compression type
         CompressionType _compressed;
         int _min_tile_dimension;
 
-        // TileDB variables
+        // Tiling policy, and the tile size (FIXED) or the expected
+        // region size (REGION_READS) it uses
+        TilingPolicy _tiling;
+        int _tiling_size;
+
+        // Threads used for TileDB reads (0 uses the OpenMP default)
+        int _num_threads;
+
+        // TileDB variables (the context is borrowed from TDBContextPool)
         std::vector<int> _array_dimension;
         std::vector<int> _tile_dimension;
         TileDB_CTX* _ctx;
@@ -116,6 +127,23 @@ namespace VCL {
          */
         TDBObject& operator=(const TDBObject &tdb);
 
+        /**
+         *  Creates a TDBObject by taking over the state and the TileDB
+         *    context of an existing TDBObject
+         *
+         *  @param tdb  The TDBObject to move from, left without a context
+         */
+        TDBObject(TDBObject &&tdb) noexcept;
+
+        /**
+         *  Swaps the state and TileDB context of this TDBObject with
+         *    another one, which releases them when it is destroyed
+         *
+         *  @param tdb  The TDBObject to move from
+         *  @return The current TDBObject
+         */
+        TDBObject& operator=(TDBObject &&tdb) noexcept;
+
         ~TDBObject();
 
 
@@ -129,6 +157,14 @@ namespace VCL {
          */
         std::string get_image_id() const;
 
+        /**
+         *  Gets the number of threads used when reading the TDBObject
+         *
+         *  @return The number of threads, resolved to the OpenMP
+         *    default if no value has been set
+         */
+        int get_num_threads() const;
+
 
     /*  *********************** */
     /*        SET FUNCTIONS     */
@@ -166,6 +202,26 @@ namespace VCL {
          */
         void set_minimum(int dimension);
 
+        /**
+         *  Sets how the tile extents are chosen when the TDBObject is
+         *    written. The minimum tile dimension only applies to FACTOR
+         *
+         *  @param policy  The TilingPolicy, FACTOR by default
+         *  @param size  The length of the tiles for FIXED, or of the
+         *    regions expected to be read for REGION_READS (256 if 0)
+         *  @see utils.h for details on TilingPolicy
+         */
+        void set_tiling(TilingPolicy policy, int size = 0);
+
+        /**
+         *  Sets the number of threads used when reading the TDBObject.
+         *    Reads are split into strips of tile rows, so more threads
+         *    than tile rows are never used
+         *
+         *  @param threads  The number of threads, 0 uses the OpenMP default
+         */
+        void set_num_threads(int threads);
+
         /**
          *  Implemented by the specific TDBObject classes, sets
          *    the names of the dimensions to standard defaults
@@ -281,6 +337,14 @@ namespace VCL {
          *    variables equal to
          */
         void set_equal(const TDBObject &tdb);
+
+        /**
+         *  Swaps the member variables, including the TileDB context,
+         *    of one TDBObject with another
+         *
+         *  @param  tdb  The TDBObject to swap with
+         */
+        void swap_equal(TDBObject &tdb) noexcept;
         /**
          *  Determines the TileDB schema variables and sets the
          *    schema for writing the TileDB file
@@ -308,9 +372,12 @@ namespace VCL {
          *  @param  buffer_var_keys  A buffer containing the metadata keys
          *  @param  buffer_keys  A buffer containing the offset values to the metadata keys
          *  @param  var_keys_size  The size of the metadata keys buffer
+         *  @param  num_keys  The number of metadata keys
+         *  @param  cell_val_num  The number of values for each key
          */
         void write_metadata(const std::string &metadata, int64_t* buffer, char* buffer_var_keys,
-            size_t* buffer_keys, size_t var_keys_size);
+            size_t* buffer_keys, size_t var_keys_size, int num_keys,
+            int cell_val_num = 1);
 
         /**
          *  Implemented by the specific TDBObject class, reads the
@@ -320,16 +387,15 @@ namespace VCL {
 
         /**
          *  Determines the size of the TDBObject array as well as
-         *    the size of the tiles. Currently tiles have the same
-         *    length in all dimensions, and the minimum number of
-         *    tiles is 100
+         *    the size of the tiles according to the tiling policy.
+         *    Arrays are padded to a multiple of the tile size
          */
         void find_tile_extents();
 
     private:
         /**
-         *  Sets the TileDB type of the attribute values, currently
-         *    all are unsigned characters
+         *  Sets the TileDB type of the attribute values, all
+         *    attributes have the same type
          *
          *  @param  types  An array to be filled with the attribute
          *    value types
@@ -344,6 +410,18 @@ namespace VCL {
          */
         int greatest_factor(int a);
 
+        /**
+         *  Estimates the cost of reading the TDBObject with square tiles
+         *    of a given length, as the number of cells read plus a fixed
+         *    cost per tile read. The whole object is read for FULL_READS
+         *    and regions of _tiling_size for REGION_READS, including the
+         *    padding in the tiles at the edges
+         *
+         *  @param tile  The length of the tiles, clamped to each dimension
+         *  @return  The estimated cost, in cells
+         */
+        double tiling_cost(int tile);
+
 
         /**
          *  Resets the arrays that are members of this class
@@ -61,6 +61,50 @@ namespace VCL {
         return ((ecx & flag_rdrand) == flag_rdrand);
     }
 
+    bool supports_ssse3()
+    {
+        const unsigned int flag_ssse3 = (1 << 9);
+
+        unsigned int eax, ebx, ecx, edx;
+        __cpuid(1, eax, ebx, ecx, edx);
+
+        return ((ecx & flag_ssse3) == flag_ssse3);
+    }
+
+    bool supports_sse41()
+    {
+        const unsigned int flag_sse41 = (1 << 19);
+
+        unsigned int eax, ebx, ecx, edx;
+        __cpuid(1, eax, ebx, ecx, edx);
+
+        return ((ecx & flag_sse41) == flag_sse41);
+    }
+
+    bool supports_avx2()
+    {
+        const unsigned int flag_avx = (1 << 28) | (1 << 27); // AVX, OSXSAVE
+        const unsigned int flag_avx2 = (1 << 5);
+        const unsigned int flag_ymm = 0x6; // XMM and YMM state enabled
+
+        unsigned int eax, ebx, ecx, edx;
+        __cpuid(1, eax, ebx, ecx, edx);
+
+        if ( (ecx & flag_avx) != flag_avx )
+            return false;
+
+        // The OS has to save the YMM registers for AVX code to be safe
+        unsigned int xcr0, xcr0_high;
+        __asm("xgetbv" : "=a"(xcr0), "=d"(xcr0_high) : "c"(0));
+
+        if ( (xcr0 & flag_ymm) != flag_ymm || __get_cpuid_max(0, NULL) < 7 )
+            return false;
+
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+        return ((ebx & flag_avx2) == flag_avx2);
+    }
+
     uint64_t combine(uint64_t a, uint64_t b)
     {
         int multiplier = 1;
@@ -0,0 +1,106 @@
+/**
+ * @file   ImageBatch_test.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "ImageBatch.h"
+#include "gtest/gtest.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <string>
+
+
+class ImageBatchTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        img_ = "images/large1.jpg";
+        cv_img_ = cv::imread(img_, cv::IMREAD_ANYCOLOR);
+    }
+
+    std::string img_;
+    cv::Mat cv_img_;
+};
+
+
+TEST_F(ImageBatchTest, DefaultConstructor)
+{
+    VCL::ImageBatch batch;
+
+    EXPECT_EQ(0, batch.size());
+    EXPECT_EQ(0, batch.get_num_stored());
+    EXPECT_EQ(0, batch.get_images_per_second());
+}
+
+TEST_F(ImageBatchTest, Store)
+{
+    VCL::ImageBatch batch;
+    batch.set_num_threads(2);
+
+    batch.add(img_, "tdb/batch/from_path");
+    batch.add(VCL::Image(cv_img_), "tdb/batch/from_mat");
+
+    VCL::Image cropped(img_);
+    cropped.crop(VCL::Rectangle(0, 0, 100, 50));
+    batch.add(std::move(cropped), "tdb/batch/cropped");
+
+    EXPECT_EQ(3, batch.size());
+
+    batch.store(VCL::TDB);
+
+    EXPECT_EQ(0, batch.size());
+    EXPECT_EQ(3, batch.get_num_stored());
+    EXPECT_GT(batch.get_images_per_second(), 0);
+
+    const std::vector<VCL::ImageBatch::Status> &status = batch.get_status();
+    ASSERT_EQ(3, status.size());
+    EXPECT_EQ("tdb/batch/from_path", status[0].image_id);
+    EXPECT_EQ(size_t(cv_img_.total() * cv_img_.channels()), status[0].bytes);
+    EXPECT_EQ(size_t(100 * 50 * cv_img_.channels()), status[2].bytes);
+
+    VCL::Image stored("tdb/batch/from_mat.tdb");
+    EXPECT_EQ(cv_img_.size(), stored.get_dimensions());
+}
+
+TEST_F(ImageBatchTest, StoreReportsErrors)
+{
+    VCL::ImageBatch batch;
+
+    batch.add("images/missing.jpg", "tdb/batch/missing");
+    batch.add(img_, "tdb/batch/present");
+
+    batch.store(VCL::TDB);
+
+    const std::vector<VCL::ImageBatch::Status> &status = batch.get_status();
+    ASSERT_EQ(2, status.size());
+    EXPECT_FALSE(status[0].stored);
+    EXPECT_FALSE(status[0].error.empty());
+    EXPECT_TRUE(status[1].stored);
+    EXPECT_EQ(1, batch.get_num_stored());
+}
@@ -0,0 +1,170 @@
+/**
+ * @file   ImageCache_test.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "ImageCache.h"
+#include "Image.h"
+#include "gtest/gtest.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <cstdio>
+#include <string>
+
+
+class ImageCacheTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        cache_ = &VCL::ImageCache::instance();
+        cache_->clear();
+        cache_->reset_counters();
+
+        img_ = "images/large1.jpg";
+        cv_img_ = cv::imread(img_, cv::IMREAD_ANYCOLOR);
+        image_size_ = cv_img_.total() * cv_img_.elemSize();
+    }
+
+    virtual void TearDown() {
+        cache_->set_capacity(0);
+        cache_->clear();
+    }
+
+    VCL::ImageCache* cache_;
+    std::string img_;
+    cv::Mat cv_img_;
+    size_t image_size_;
+};
+
+
+TEST_F(ImageCacheTest, Disabled)
+{
+    cv::Mat cached;
+
+    cache_->put("image", cv_img_);
+    EXPECT_FALSE(cache_->get("image", cached));
+
+    EXPECT_EQ(0, cache_->get_num_entries());
+    EXPECT_EQ(0, cache_->get_misses());
+}
+
+TEST_F(ImageCacheTest, EvictLeastRecentlyUsed)
+{
+    cache_->set_capacity(2 * image_size_);
+
+    cv::Mat cached;
+    cache_->put("first", cv_img_);
+    cache_->put("second", cv_img_);
+    EXPECT_TRUE(cache_->get("first", cached));
+
+    // The second image is the least recently used
+    cache_->put("third", cv_img_);
+    EXPECT_FALSE(cache_->get("second", cached));
+    EXPECT_TRUE(cache_->get("first", cached));
+    EXPECT_TRUE(cache_->get("third", cached));
+
+    EXPECT_EQ(2, cache_->get_num_entries());
+    EXPECT_EQ(2 * image_size_, cache_->get_size());
+    EXPECT_EQ(3, cache_->get_hits());
+    EXPECT_EQ(1, cache_->get_misses());
+    EXPECT_EQ(1, cache_->get_evictions());
+
+    cache_->set_capacity(image_size_);
+    EXPECT_EQ(1, cache_->get_num_entries());
+    EXPECT_EQ(2, cache_->get_evictions());
+}
+
+TEST_F(ImageCacheTest, ReadImage)
+{
+    cache_->set_capacity(4 * image_size_);
+
+    VCL::Rectangle rect(100, 100, 200, 150);
+
+    VCL::Image first(img_);
+    first.crop(rect);
+    cv::Mat first_mat = first.get_cvmat();
+    EXPECT_EQ(1, cache_->get_misses());
+
+    // The same file and operations are served from memory
+    VCL::Image second(img_);
+    second.crop(rect);
+    cv::Mat second_mat = second.get_cvmat();
+    EXPECT_EQ(1, cache_->get_hits());
+    EXPECT_EQ(0, cv::norm(first_mat, second_mat, cv::NORM_INF));
+
+    // Other operations are another entry
+    VCL::Image other(img_);
+    other.threshold(100);
+    other.get_cvmat();
+    EXPECT_EQ(2, cache_->get_misses());
+    EXPECT_EQ(2, cache_->get_num_entries());
+}
+
+TEST_F(ImageCacheTest, ModifyCachedImage)
+{
+    cache_->set_capacity(4 * image_size_);
+
+    // Neither the image that fills the cache nor one served from it
+    // shares its data with the cache
+    VCL::Image first(img_);
+    cv::Mat first_mat = first.get_cvmat();
+    first_mat.setTo(cv::Scalar::all(0));
+
+    VCL::Image second(img_);
+    cv::Mat second_mat = second.get_cvmat();
+    EXPECT_EQ(1, cache_->get_hits());
+    EXPECT_EQ(0, cv::norm(second_mat, cv_img_, cv::NORM_INF));
+    second_mat.setTo(cv::Scalar::all(0));
+
+    VCL::Image third(img_);
+    cv::Mat third_mat = third.get_cvmat();
+    EXPECT_EQ(2, cache_->get_hits());
+    EXPECT_EQ(0, cv::norm(third_mat, cv_img_, cv::NORM_INF));
+}
+
+TEST_F(ImageCacheTest, ReadRewrittenImage)
+{
+    cache_->set_capacity(4 * image_size_);
+
+    std::string path = "images/cache_test.png";
+    cv::Mat small(cv_img_, cv::Rect(0, 0, 64, 48));
+    cv::imwrite(path, small);
+
+    VCL::Image first(path);
+    EXPECT_EQ(64, first.get_cvmat().cols);
+
+    cv::Mat other(cv_img_, cv::Rect(0, 0, 32, 24));
+    cv::imwrite(path, other);
+
+    VCL::Image second(path);
+    EXPECT_EQ(32, second.get_cvmat().cols);
+    EXPECT_EQ(0, cache_->get_hits());
+
+    std::remove(path.c_str());
+}
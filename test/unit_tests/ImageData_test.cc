@@ -34,6 +34,7 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include <cstdio>
 #include <string>
 
 
@@ -183,6 +184,29 @@ TEST_F(ImageDataTest, BufferConstructor)
     compare_mat_buffer(cv_img_, buf);
 }
 
+TEST_F(ImageDataTest, BufferConstructorTyped)
+{
+    cv::Mat depth(cv_img_.rows, cv_img_.cols, CV_16UC1);
+    cv::randu(depth, 0, 65535);
+
+    VCL::ImageData img_data(depth.data, cv::Size(depth.cols, depth.rows),
+        depth.type());
+    img_data.write("tdb/images/depth_buffer", VCL::TDB);
+    img_data.perform_operations();
+
+    VCL::ImageData stored("tdb/images/depth_buffer.tdb");
+    EXPECT_EQ(CV_16UC1, stored.get_type());
+
+    int size = stored.get_size();
+    std::vector<unsigned short> buffer(size);
+    stored.get_buffer(buffer.data(), size);
+
+    cv::Mat stored_mat(depth.rows, depth.cols, CV_16UC1, buffer.data());
+    EXPECT_EQ(0, cv::norm(stored_mat, depth, cv::NORM_INF));
+
+    stored.delete_object();
+}
+
 TEST_F(ImageDataTest, CopyConstructorMat)
 {
     VCL::ImageData img_data(cv_img_);
@@ -403,6 +427,129 @@ TEST_F(ImageDataTest, Threshold)
     compare_mat_mat(cv_bright, cv_img_);
 }
 
+TEST_F(ImageDataTest, PlanOperations)
+{
+    VCL::ImageData img_data(tdb_img_);
+
+    img_data.read(tdb_img_);
+    img_data.threshold(100);
+    img_data.crop(VCL::Rectangle(50, 20, 300, 200));
+    img_data.crop(VCL::Rectangle(10, 30, 120, 90));
+    img_data.threshold(150);
+
+    cv::Mat planned = img_data.get_cvmat();
+
+    cv::Mat expected;
+    cv::threshold(cv::Mat(cv_img_, VCL::Rectangle(60, 50, 120, 90)), expected,
+        150, 150, cv::THRESH_TOZERO);
+
+    ASSERT_EQ(90, planned.rows);
+    ASSERT_EQ(120, planned.cols);
+    compare_mat_mat(planned, expected);
+}
+
+TEST_F(ImageDataTest, CropAfterResize)
+{
+    VCL::ImageData full(tdb_img_);
+    full.read(tdb_img_);
+    full.resize(cv_img_.rows / 2, cv_img_.cols / 2);
+    cv::Mat full_mat = full.get_cvmat();
+
+    // The crop is pushed into the resize, which reads only its source area
+    VCL::ImageData img_data(tdb_img_);
+    img_data.read(tdb_img_);
+    img_data.resize(cv_img_.rows / 2, cv_img_.cols / 2);
+    img_data.crop(VCL::Rectangle(40, 30, 250, 200));
+    img_data.crop(rect_);
+
+    cv::Mat planned = img_data.get_cvmat();
+    cv::Mat expected(full_mat, VCL::Rectangle(140, 130, 100, 100));
+
+    ASSERT_EQ(rect_.size(), planned.size());
+    compare_mat_mat(planned, expected);
+}
+
+TEST_F(ImageDataTest, GetAreaAfterCopy)
+{
+    VCL::ImageData img_data(tdb_img_);
+    img_data.read(tdb_img_);
+
+    VCL::ImageData copy(img_data);
+    VCL::ImageData area = copy.get_area(rect_);
+
+    cv::Mat area_mat = area.get_cvmat();
+    cv::Mat expected(cv_img_, rect_);
+
+    ASSERT_EQ(rect_.size(), area_mat.size());
+    compare_mat_mat(area_mat, expected);
+}
+
+TEST_F(ImageDataTest, ResizeReducedJPEG)
+{
+    VCL::ImageData img_data(img_);
+
+    img_data.read(img_);
+    img_data.resize(cv_img_.rows / 8, cv_img_.cols / 8);
+
+    cv::Mat resized = img_data.get_cvmat();
+
+    // Decoded at 1/8 of the size, so the final resize has nothing to do
+    cv::Mat expected = cv::imread(img_, cv::IMREAD_REDUCED_COLOR_8);
+
+    ASSERT_EQ(cv_img_.rows / 8, resized.rows);
+    ASSERT_EQ(cv_img_.cols / 8, resized.cols);
+    compare_mat_mat(resized, expected);
+}
+
+TEST_F(ImageDataTest, InferDimensions)
+{
+    VCL::ImageData img_data(tdb_img_);
+
+    img_data.read(tdb_img_);
+    img_data.crop(rect_);
+    img_data.resize(40, 60);
+
+    // Known from the TileDB metadata and the queued operations
+    cv::Size dims = img_data.get_dimensions();
+    EXPECT_EQ(40, dims.height);
+    EXPECT_EQ(60, dims.width);
+    EXPECT_EQ(cv_img_.type(), img_data.get_type());
+    EXPECT_EQ(40 * 60 * cv_img_.channels(), img_data.get_size());
+
+    cv::Mat mat = img_data.get_cvmat();
+    EXPECT_EQ(dims, mat.size());
+}
+
+TEST_F(ImageDataTest, InferDimensionsEncoded)
+{
+    VCL::ImageData jpg_data(img_);
+    jpg_data.read(img_);
+
+    // Known from the JPEG frame header
+    EXPECT_EQ(cv_img_.size(), jpg_data.get_dimensions());
+    EXPECT_EQ(cv_img_.type(), jpg_data.get_type());
+    EXPECT_EQ(cv_img_.rows * cv_img_.cols * cv_img_.channels(),
+        jpg_data.get_size());
+
+    jpg_data.resize(cv_img_.rows / 8, cv_img_.cols / 8);
+    EXPECT_EQ(cv::Size(cv_img_.cols / 8, cv_img_.rows / 8),
+        jpg_data.get_dimensions());
+
+    cv::Mat gray;
+    cv::cvtColor(cv_img_, gray, cv::COLOR_BGR2GRAY);
+    cv::imwrite("images/gray.png", gray);
+
+    // Known from the PNG IHDR chunk
+    VCL::ImageData png_data("images/gray.png");
+    png_data.read("images/gray.png");
+
+    EXPECT_EQ(gray.size(), png_data.get_dimensions());
+    EXPECT_EQ(CV_8UC1, png_data.get_type());
+    EXPECT_EQ(gray.rows * gray.cols, png_data.get_size());
+
+    std::remove("images/gray.png");
+}
+
 TEST_F(ImageDataTest, DeleteTDB)
 {
     VCL::ImageData img_data("tdb/images/no_metadata.tdb");
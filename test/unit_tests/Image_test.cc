@@ -38,6 +38,8 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/highgui.hpp>
 #include <string>
+#include <utility>
+#include <vector>
 
 class ImageTest : public ::testing::Test {
  protected:
@@ -219,6 +221,49 @@ TEST_F(ImageTest, CopyConstructorComplex)
 }
 
 
+TEST_F(ImageTest, MoveConstructor)
+{
+    VCL::Image img(cv_img_);
+    cv::Mat img_cv = img.get_cvmat();
+
+    VCL::Image test_img(std::move(img));
+
+    // The data is handed over, not copied
+    cv::Mat test_cv = test_img.get_cvmat();
+    EXPECT_EQ(img_cv.data, test_cv.data);
+    compare_mat_mat(test_cv, cv_img_);
+}
+
+TEST_F(ImageTest, CopyAssignAfterMove)
+{
+    VCL::Image img(cv_img_);
+    VCL::Image test_img(std::move(img));
+
+    // A moved from Image can be assigned to again
+    img = test_img;
+
+    cv::Mat img_cv = img.get_cvmat();
+    compare_mat_mat(img_cv, cv_img_);
+}
+
+TEST_F(ImageTest, MoveAssignment)
+{
+    VCL::Image img(tdb_img_);
+    VCL::Image test_img(cv_img_);
+
+    test_img = std::move(img);
+
+    EXPECT_EQ(VCL::TDB, test_img.get_image_format());
+
+    cv::Mat test_cv = test_img.get_cvmat();
+    compare_mat_mat(test_cv, cv_img_);
+
+    std::vector<VCL::Image> images;
+    images.push_back(std::move(test_img));
+    images.emplace_back(cv_img_);
+    EXPECT_EQ(cv_img_.size(), images[0].get_dimensions());
+}
+
 TEST_F(ImageTest, GetMatFromMat)
 {
     VCL::Image img(cv_img_);
@@ -381,6 +426,40 @@ TEST_F(ImageTest, ResizeTDB)
     EXPECT_EQ(dimension_, cv_img.rows);
 }
 
+TEST_F(ImageTest, ResizeTDBPyramid)
+{
+    VCL::Image img(cv_img_);
+    img.set_pyramid_levels(2);
+    img.store("tdb/images/pyramid_image.tdb", VCL::TDB);
+
+    VCL::Image small("tdb/images/pyramid_image.tdb");
+    small.resize(cv_img_.rows / 3, cv_img_.cols / 3);
+
+    cv::Mat cv_img = small.get_cvmat();
+
+    EXPECT_EQ(cv_img_.rows / 3, cv_img.rows);
+    EXPECT_EQ(cv_img_.cols / 3, cv_img.cols);
+
+    small.delete_image();
+}
+
+TEST_F(ImageTest, CropTDBRegionTiles)
+{
+    VCL::Image img(cv_img_);
+    img.set_tiling(VCL::TilingPolicy::REGION_READS, rect_.width);
+    img.store("tdb/images/region_image.tdb", VCL::TDB);
+
+    VCL::Image area("tdb/images/region_image.tdb");
+    area.crop(rect_);
+
+    cv::Mat cv_img = area.get_cvmat();
+    cv::Mat expected(cv_img_, rect_);
+
+    compare_mat_mat(cv_img, expected);
+
+    area.delete_image();
+}
+
 TEST_F(ImageTest, CropMatThrow)
 {
     VCL::Image img(img_);
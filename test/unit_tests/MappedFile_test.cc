@@ -0,0 +1,75 @@
+/**
+ * @file   MappedFile_test.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "MappedFile.h"
+#include "Exception.h"
+#include "gtest/gtest.h"
+
+#include <fstream>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+
+class MappedFileTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        img_ = "images/large1.jpg";
+    }
+
+    std::string img_;
+};
+
+
+TEST_F(MappedFileTest, Size)
+{
+    std::ifstream file(img_, std::ios::binary | std::ios::ate);
+
+    VCL::MappedFile mapped(img_);
+
+    EXPECT_EQ(size_t(file.tellg()), mapped.get_size());
+}
+
+TEST_F(MappedFileTest, Decode)
+{
+    cv::Mat expected = cv::imread(img_, cv::IMREAD_ANYCOLOR);
+
+    VCL::MappedFile mapped(img_, true);
+    cv::Mat decoded = cv::imdecode(mapped.get_cvmat(), cv::IMREAD_ANYCOLOR);
+
+    ASSERT_EQ(expected.size(), decoded.size());
+    EXPECT_EQ(0, cv::norm(expected, decoded, cv::NORM_INF));
+}
+
+TEST_F(MappedFileTest, MissingFile)
+{
+    ASSERT_THROW(VCL::MappedFile mapped("images/missing.jpg"), VCL::Exception);
+}
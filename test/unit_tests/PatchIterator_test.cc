@@ -0,0 +1,133 @@
+/**
+ * @file   PatchIterator_test.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "PatchIterator.h"
+#include "TDBImage.h"
+#include "Image.h"
+#include "gtest/gtest.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <string>
+
+
+class PatchIteratorTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        tdb_img_ = "tdb/images/patches.tdb";
+        cv_img_ = cv::imread("images/large1.jpg", cv::IMREAD_ANYCOLOR);
+    }
+
+    // Visits every patch, checking it against the same area of the image
+    int check_patches(VCL::PatchIterator &it, cv::Size size, cv::Size stride)
+    {
+        int count = 0;
+        VCL::Rectangle expected(0, 0, size.width, size.height);
+
+        for ( ; !it.end(); it.next() ) {
+            EXPECT_EQ(expected, it.get_area());
+
+            cv::Mat patch = it.get_patch();
+            cv::Mat area(cv_img_, it.get_area());
+            EXPECT_EQ(0, cv::norm(patch, area, cv::NORM_INF));
+
+            expected.x += stride.width;
+            if ( expected.x + size.width > cv_img_.cols ) {
+                expected.x = 0;
+                expected.y += stride.height;
+            }
+            ++count;
+        }
+
+        return count;
+    }
+
+    std::string tdb_img_;
+    cv::Mat cv_img_;
+};
+
+
+TEST_F(PatchIteratorTest, IterateMat)
+{
+    cv::Size size(200, 150);
+    cv::Size stride(100, 100);
+
+    VCL::PatchIterator it(cv_img_, size, stride);
+
+    // 9 patches along the 1024 columns and 5 down the 640 rows
+    EXPECT_EQ(45, it.get_num_patches());
+    EXPECT_EQ(45, check_patches(it, size, stride));
+    ASSERT_THROW(it.get_patch(), VCL::Exception);
+}
+
+TEST_F(PatchIteratorTest, IterateTDB)
+{
+    VCL::TDBImage tdb(tdb_img_);
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 128);
+    tdb.write(cv_img_);
+
+    // Patches span up to three rows of tiles, and the stride skips some
+    cv::Size size(100, 200);
+    cv::Size stride(150, 170);
+
+    VCL::Image img(tdb_img_);
+    VCL::PatchIterator it = img.get_patches(size, stride);
+
+    EXPECT_EQ(it.get_num_patches(), check_patches(it, size, stride));
+
+    tdb.delete_image();
+}
+
+TEST_F(PatchIteratorTest, IterateAfterOperations)
+{
+    VCL::Image img(cv_img_);
+    img.threshold(100);
+
+    VCL::PatchIterator it = img.get_patches(cv::Size(64, 64), cv::Size(64, 64));
+    cv::Mat threshold = img.get_cvmat();
+
+    EXPECT_EQ(160, it.get_num_patches());
+    EXPECT_EQ(0, cv::norm(it.get_patch(), threshold(it.get_area()),
+        cv::NORM_INF));
+}
+
+TEST_F(PatchIteratorTest, InvalidWindow)
+{
+    ASSERT_THROW(VCL::PatchIterator(cv_img_, cv::Size(0, 10), cv::Size(1, 1)),
+        VCL::Exception);
+    ASSERT_THROW(VCL::PatchIterator(cv_img_, cv::Size(10, 10), cv::Size(0, 1)),
+        VCL::Exception);
+
+    // Patches larger than the image leave nothing to iterate
+    VCL::PatchIterator it(cv_img_, cv::Size(cv_img_.cols + 1, 10), cv::Size(1, 1));
+    EXPECT_TRUE(it.end());
+    EXPECT_EQ(0, it.get_num_patches());
+}
@@ -0,0 +1,115 @@
+/**
+ * @file   TDBContextPool_test.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "TDBContextPool.h"
+#include "TDBImage.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+
+class TDBContextPoolTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        pool_ = &VCL::TDBContextPool::instance();
+        pool_->configure(VCL::TDBContextPool::SHARED,
+            VCL::TDBContextPool::REFCOUNTED);
+        pool_->clear();
+    }
+
+    virtual void TearDown() {
+        pool_->configure(VCL::TDBContextPool::SHARED,
+            VCL::TDBContextPool::PROCESS);
+    }
+
+    VCL::TDBContextPool* pool_;
+};
+
+
+TEST_F(TDBContextPoolTest, AcquireRelease)
+{
+    TileDB_CTX* first = pool_->acquire();
+    TileDB_CTX* second = pool_->acquire();
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(1, pool_->get_num_contexts());
+
+    pool_->release(first);
+    EXPECT_EQ(1, pool_->get_num_contexts());
+
+    pool_->release(second);
+    EXPECT_EQ(0, pool_->get_num_contexts());
+}
+
+TEST_F(TDBContextPoolTest, SharedContext)
+{
+    {
+        VCL::TDBImage tdb;
+        VCL::TDBImage tdb_copy(tdb);
+        VCL::TDBImage tdb_other("tdb/images/test_image.tdb");
+
+        EXPECT_EQ(1, pool_->get_num_contexts());
+    }
+
+    EXPECT_EQ(0, pool_->get_num_contexts());
+}
+
+TEST_F(TDBContextPoolTest, PerThreadContext)
+{
+    pool_->configure(VCL::TDBContextPool::PER_THREAD,
+        VCL::TDBContextPool::REFCOUNTED);
+
+    VCL::TDBImage tdb;
+
+    int contexts = 0;
+    std::thread worker([&]() {
+        VCL::TDBImage worker_tdb;
+        contexts = pool_->get_num_contexts();
+    });
+    worker.join();
+
+    EXPECT_EQ(2, contexts);
+    EXPECT_EQ(1, pool_->get_num_contexts());
+}
+
+TEST_F(TDBContextPoolTest, ProcessLifetime)
+{
+    pool_->configure(VCL::TDBContextPool::SHARED,
+        VCL::TDBContextPool::PROCESS);
+
+    {
+        VCL::TDBImage tdb;
+    }
+    EXPECT_EQ(1, pool_->get_num_contexts());
+
+    pool_->clear();
+    EXPECT_EQ(0, pool_->get_num_contexts());
+}
@@ -35,7 +35,12 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 class TDBImageTest : public ::testing::Test {
 
@@ -106,6 +111,55 @@ protected:
         }
     }
 
+    // The floating point bilinear resize TDBImage used before the fixed
+    // point kernel, kept as a reference for its output
+    cv::Mat reference_resize(const cv::Mat &img, cv::Size size)
+    {
+        int channels = img.channels();
+        cv::Mat resized(size, img.type());
+
+        float row_ratio = img.rows / float(size.height);
+        float column_ratio = img.cols / float(size.width);
+
+        auto interpolate = [](double x1, double val1, double x2,
+            double val2, double x) {
+            if ( x1 == x2 )
+                return val1;
+            return val1 + ((val2 - val1) / (x2 - x1) * (x - x1));
+        };
+
+        for ( int r = 0; r < size.height; ++r ) {
+            float scale_r = ( r + 0.5 ) * row_ratio - 0.5;
+            int row_top = std::max(int(floor(scale_r)), 0);
+            int row_bottom = std::min(int(floor(scale_r + 1)), img.rows - 1);
+
+            const unsigned char* top = img.ptr<unsigned char>(row_top);
+            const unsigned char* bottom = img.ptr<unsigned char>(row_bottom);
+            unsigned char* out = resized.ptr<unsigned char>(r);
+
+            for ( int c = 0; c < size.width; ++c ) {
+                float scale_c = ( c + 0.5 ) * column_ratio - 0.5;
+                int left = std::max(int(floor(scale_c)), 0);
+                int right = std::min(int(floor(scale_c + 1)), img.cols - 1);
+
+                for ( int x = 0; x < channels; ++x ) {
+                    double top_value = interpolate(left,
+                        top[left * channels + x], right,
+                        top[right * channels + x], scale_c);
+                    double bottom_value = interpolate(left,
+                        bottom[left * channels + x], right,
+                        bottom[right * channels + x], scale_c);
+                    double middle = interpolate(row_top, top_value,
+                        row_bottom, bottom_value, scale_r);
+
+                    out[c * channels + x] = floor(middle + 0.5);
+                }
+            }
+        }
+
+        return resized;
+    }
+
     void compare_buffer_buffer(unsigned char* buffer1, unsigned char* buffer2, int length)
     {
         for ( int i = 0; i < length; ++i ) {
@@ -230,6 +284,19 @@ TEST_F(TDBImageTest, CopyConstructor)
     imgcopy.write("tdb/images/copy_construct.tdb");
 }
 
+TEST_F(TDBImageTest, MoveConstructor)
+{
+    VCL::TDBImage tdb(tdb_img_);
+    tdb.read();
+    cv::Mat data = tdb.get_cvmat();
+
+    VCL::TDBImage moved(std::move(tdb));
+
+    EXPECT_FALSE(tdb.has_data());
+    EXPECT_EQ(data.data, moved.get_cvmat().data);
+    EXPECT_EQ(cv_img_.rows, moved.get_image_height());
+}
+
 TEST_F(TDBImageTest, OperatorEqualsNoData)
 {
     VCL::TDBImage tdb("tdb/images/operator_equals.tdb");
@@ -329,6 +396,20 @@ TEST_F(TDBImageTest, GetCVMat)
     compare_mat_mat(cv_img, cv_img_);
 }
 
+TEST_F(TDBImageTest, GetCVMatShared)
+{
+    VCL::TDBImage tdb(tdb_img_);
+
+    cv::Mat first = tdb.get_cvmat();
+    cv::Mat second = tdb.get_cvmat();
+    EXPECT_EQ(first.data, second.data);
+
+    // Operations replace the data, so earlier Mats are left untouched
+    tdb.threshold(200);
+    EXPECT_NE(first.data, tdb.get_cvmat().data);
+    compare_mat_mat(first, cv_img_);
+}
+
 TEST_F(TDBImageTest, GetBuffer)
 {
     VCL::TDBImage tdb(tdb_img_);
@@ -390,6 +471,30 @@ TEST_F(TDBImageTest, WriteString)
     EXPECT_EQ(cv_img_.cols, tdb.get_image_width());
 }
 
+TEST_F(TDBImageTest, WriteAttributes)
+{
+    // A view into the image, so the rows are not continuous
+    cv::Mat area = cv_img_(rect_);
+
+    VCL::TDBImage tdb("tdb/images/attributes.tdb");
+    tdb.set_num_attributes(3);
+    tdb.write(area);
+
+    VCL::TDBImage planar("tdb/images/attributes.tdb");
+    planar.read();
+    cv::Mat planar_mat = planar.get_cvmat();
+
+    compare_mat_mat(planar_mat, area);
+
+    planar.write("tdb/images/attributes_copy.tdb");
+
+    VCL::TDBImage copy("tdb/images/attributes_copy.tdb");
+    copy.read();
+    cv::Mat copy_mat = copy.get_cvmat();
+
+    compare_mat_mat(copy_mat, area);
+}
+
 TEST_F(TDBImageTest, Read)
 {
     VCL::TDBImage tdb(tdb_img_);
@@ -400,6 +505,43 @@ TEST_F(TDBImageTest, Read)
     EXPECT_EQ(cv_img_.cols, tdb.get_image_width());
 }
 
+TEST_F(TDBImageTest, ReadThreads)
+{
+    // Small tiles give every thread strips to read
+    VCL::TDBImage tdb("tdb/images/read_threads.tdb");
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 64);
+    tdb.write(cv_img_);
+
+    VCL::TDBImage serial("tdb/images/read_threads.tdb");
+    serial.set_num_threads(1);
+    serial.read();
+
+    VCL::TDBImage parallel("tdb/images/read_threads.tdb");
+    parallel.set_num_threads(4);
+    parallel.read();
+
+    cv::Mat serial_mat = serial.get_cvmat();
+    cv::Mat parallel_mat = parallel.get_cvmat();
+
+    compare_mat_mat(serial_mat, parallel_mat);
+    compare_mat_mat(parallel_mat, cv_img_);
+
+    // The first and last strips are only partly read
+    VCL::Rectangle rect(37, 70, 300, 250);
+
+    VCL::TDBImage area("tdb/images/read_threads.tdb");
+    area.set_num_threads(4);
+    area.read(rect);
+
+    cv::Mat area_mat = area.get_cvmat();
+    cv::Mat expected(cv_img_, rect);
+    EXPECT_EQ(rect.height, area_mat.rows);
+    EXPECT_EQ(rect.width, area_mat.cols);
+    EXPECT_EQ(0, cv::norm(area_mat, expected, cv::NORM_INF));
+
+    tdb.delete_image();
+}
+
 TEST_F(TDBImageTest, ReadRectangle)
 {
     VCL::TDBImage tdb(tdb_test_);
@@ -422,6 +564,360 @@ TEST_F(TDBImageTest, Resize)
     EXPECT_EQ(100, tdb.get_image_width());
 }
 
+TEST_F(TDBImageTest, ResizeArea)
+{
+    VCL::Rectangle size(0, 0, cv_img_.cols / 2, cv_img_.rows / 2);
+
+    VCL::TDBImage full(tdb_img_);
+    full.resize(size);
+    cv::Mat full_mat = full.get_cvmat();
+
+    VCL::TDBImage area(tdb_img_);
+    area.resize(size, rect_);
+    cv::Mat area_mat = area.get_cvmat();
+    cv::Mat expected(full_mat, rect_);
+
+    EXPECT_EQ(rect_.height, area.get_image_height());
+    EXPECT_EQ(rect_.width, area.get_image_width());
+    compare_mat_mat(area_mat, expected);
+
+    ASSERT_THROW(area.resize(size, VCL::Rectangle(0, 0, size.width + 1, 1)),
+        VCL::Exception);
+}
+
+TEST_F(TDBImageTest, ResizeMatchesOpenCV)
+{
+    VCL::TDBImage tdb(tdb_img_);
+
+    tdb.resize(VCL::Rectangle(0, 0, 300, 200));
+    cv::Mat tdb_small = tdb.get_cvmat();
+
+    cv::Mat cv_small;
+    cv::resize(cv_img_, cv_small, cv::Size(300, 200), 0, 0, cv::INTER_LINEAR);
+
+    // Both use 11 bit fixed point weights, so allow rounding differences
+    EXPECT_LE(cv::norm(tdb_small, cv_small, cv::NORM_INF), 1);
+
+    // The fixed point weights only round differently from the floating
+    // point resize they replaced
+    cv::Mat reference_small = reference_resize(cv_img_, cv::Size(300, 200));
+    EXPECT_LE(cv::norm(tdb_small, reference_small, cv::NORM_INF), 1);
+
+    VCL::TDBImage large(tdb_img_);
+    large.resize(VCL::Rectangle(0, 0, 1500, 900));
+    cv::Mat tdb_large = large.get_cvmat();
+
+    cv::Mat reference_large = reference_resize(cv_img_, cv::Size(1500, 900));
+    EXPECT_LE(cv::norm(tdb_large, reference_large, cv::NORM_INF), 1);
+}
+
+TEST_F(TDBImageTest, WritePyramid)
+{
+    VCL::TDBImage tdb("tdb/images/pyramid.tdb");
+    tdb.set_pyramid_levels(2);
+    tdb.write(cv_img_);
+
+    VCL::TDBImage stored("tdb/images/pyramid.tdb");
+    EXPECT_EQ(2, stored.get_pyramid_levels());
+
+    VCL::TDBImage level("tdb/images/pyramid.tdb_level2");
+    EXPECT_EQ(cv_img_.rows / 4, level.get_image_height());
+    EXPECT_EQ(cv_img_.cols / 4, level.get_image_width());
+
+    ASSERT_THROW(tdb.set_pyramid_levels(-1), VCL::Exception);
+}
+
+TEST_F(TDBImageTest, ResizePyramid)
+{
+    VCL::TDBImage tdb("tdb/images/pyramid_resize.tdb");
+    tdb.set_pyramid_levels(3);
+    tdb.write(cv_img_);
+
+    // Level 2 is exactly the requested size, so it is returned as is
+    VCL::TDBImage level("tdb/images/pyramid_resize.tdb_level2");
+    level.read();
+    cv::Mat level_mat = level.get_cvmat();
+
+    VCL::TDBImage resized("tdb/images/pyramid_resize.tdb");
+    resized.resize(VCL::Rectangle(0, 0, level_mat.cols, level_mat.rows));
+    cv::Mat resized_mat = resized.get_cvmat();
+
+    compare_mat_mat(resized_mat, level_mat);
+
+    resized.delete_image();
+}
+
+TEST_F(TDBImageTest, WriteTypes)
+{
+    // Depth data in one attribute and HDR color data in three
+    cv::Mat depth;
+    cv::cvtColor(cv_img_, depth, cv::COLOR_BGR2GRAY);
+    depth.convertTo(depth, CV_16UC1, 257);
+
+    cv::Mat hdr;
+    cv_img_.convertTo(hdr, CV_32FC3, 1.0 / 255);
+
+    VCL::TDBImage depth_tdb("tdb/images/depth.tdb");
+    depth_tdb.write(depth);
+
+    VCL::TDBImage hdr_tdb("tdb/images/hdr.tdb");
+    hdr_tdb.set_num_attributes(3);
+    hdr_tdb.write(hdr);
+
+    VCL::TDBImage stored_depth("tdb/images/depth.tdb");
+    EXPECT_EQ(CV_16UC1, stored_depth.get_image_type());
+    cv::Mat depth_mat = stored_depth.get_cvmat();
+    EXPECT_EQ(0, cv::norm(depth_mat, depth, cv::NORM_INF));
+
+    VCL::TDBImage stored_hdr("tdb/images/hdr.tdb");
+    EXPECT_EQ(CV_32FC3, stored_hdr.get_image_type());
+    cv::Mat hdr_mat = stored_hdr.get_cvmat();
+    EXPECT_EQ(0, cv::norm(hdr_mat, hdr, cv::NORM_INF));
+
+    // Values are converted to the type of the buffer
+    int size = stored_depth.get_image_size();
+    std::vector<float> buffer(size);
+    stored_depth.get_buffer(buffer.data(), size);
+    EXPECT_EQ(float(depth.at<unsigned short>(10, 20)),
+        buffer[10 * depth.cols + 20]);
+
+    stored_depth.delete_image();
+    stored_hdr.delete_image();
+}
+
+TEST_F(TDBImageTest, WriteAreas)
+{
+    VCL::TDBImage tdb("tdb/images/areas.tdb");
+    tdb.begin_write(cv_img_.rows, cv_img_.cols, cv_img_.type());
+
+    // Strips of rows, with the last one shorter than the others
+    int strip = cv_img_.rows / 3 + 1;
+    for ( int row = 0; row < cv_img_.rows; row += strip ) {
+        int rows = std::min(strip, cv_img_.rows - row);
+        cv::Mat area(cv_img_, cv::Rect(0, row, cv_img_.cols, rows));
+        tdb.write_area(area, row, 0);
+    }
+    tdb.end_write(true);
+
+    VCL::TDBImage stored("tdb/images/areas.tdb");
+    stored.read();
+    cv::Mat stored_mat = stored.get_cvmat();
+
+    compare_mat_mat(stored_mat, cv_img_);
+
+    stored.delete_image();
+}
+
+TEST_F(TDBImageTest, WriteAreaInvalid)
+{
+    VCL::TDBImage tdb("tdb/images/areas_invalid.tdb");
+    cv::Mat area(cv_img_, cv::Rect(0, 0, 10, 10));
+
+    ASSERT_THROW(tdb.write_area(area, 0, 0), VCL::Exception);
+
+    tdb.begin_write(cv_img_.rows, cv_img_.cols, cv_img_.type());
+    ASSERT_THROW(tdb.write_area(area, cv_img_.rows - 5, 0), VCL::Exception);
+    tdb.end_write();
+
+    ASSERT_THROW(tdb.end_write(), VCL::Exception);
+
+    tdb.delete_image();
+}
+
+TEST_F(TDBImageTest, WriteFixedTiles)
+{
+    // Neither dimension is a multiple of the tiles, so both are padded
+    VCL::TDBImage tdb("tdb/images/fixed_tiles.tdb");
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 384);
+    tdb.write(cv_img_);
+
+    VCL::TDBImage stored("tdb/images/fixed_tiles.tdb");
+    EXPECT_EQ(cv_img_.rows, stored.get_image_height());
+    EXPECT_EQ(cv_img_.cols, stored.get_image_width());
+    cv::Mat stored_mat = stored.get_cvmat();
+    compare_mat_mat(stored_mat, cv_img_);
+
+    VCL::TDBImage area("tdb/images/fixed_tiles.tdb");
+    VCL::Rectangle edge(cv_img_.cols - 100, cv_img_.rows - 50, 100, 50);
+    area.read(edge);
+    cv::Mat area_mat = area.get_cvmat();
+    cv::Mat expected(cv_img_, edge);
+    compare_mat_mat(area_mat, expected);
+
+    stored.delete_image();
+}
+
+TEST_F(TDBImageTest, WriteReadPatternTiles)
+{
+    VCL::TDBImage full("tdb/images/full_tiles.tdb");
+    full.set_tiling(VCL::TilingPolicy::FULL_READS);
+    full.write(cv_img_);
+
+    VCL::TDBImage region("tdb/images/region_tiles.tdb");
+    region.set_tiling(VCL::TilingPolicy::REGION_READS, 64);
+    region.write(cv_img_);
+
+    VCL::TDBImage stored_full("tdb/images/full_tiles.tdb");
+    cv::Mat full_mat = stored_full.get_cvmat();
+    compare_mat_mat(full_mat, cv_img_);
+
+    VCL::TDBImage stored_region("tdb/images/region_tiles.tdb");
+    stored_region.read(rect_);
+    cv::Mat region_mat = stored_region.get_cvmat();
+    cv::Mat expected(cv_img_, rect_);
+    compare_mat_mat(region_mat, expected);
+
+    ASSERT_THROW(full.set_tiling(VCL::TilingPolicy::FIXED), VCL::Exception);
+    ASSERT_THROW(full.set_tiling(VCL::TilingPolicy::REGION_READS, -1),
+        VCL::Exception);
+
+    stored_full.delete_image();
+    stored_region.delete_image();
+}
+
+TEST_F(TDBImageTest, ResizeStrips)
+{
+    VCL::TDBImage tdb("tdb/images/resize_strips.tdb");
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 128);
+    tdb.write(cv_img_);
+
+    cv::Size size(300, 200);
+
+    VCL::TDBImage full("tdb/images/resize_strips.tdb");
+    full.read();
+    full.resize(VCL::Rectangle(0, 0, size.width, size.height));
+    cv::Mat expected = full.get_cvmat();
+
+    // The strips come in order and cover the resized image
+    cv::Mat streamed(size, cv_img_.type());
+    int next_row = 0;
+
+    VCL::TDBImage stored("tdb/images/resize_strips.tdb");
+    stored.resize_strips(size, [&](const cv::Mat &strip, int row) {
+        EXPECT_EQ(next_row, row);
+        EXPECT_EQ(size.width, strip.cols);
+        cv::Mat rows = streamed.rowRange(row, row + strip.rows);
+        strip.copyTo(rows);
+        next_row += strip.rows;
+    });
+
+    EXPECT_EQ(size.height, next_row);
+    EXPECT_FALSE(stored.has_data());
+    compare_mat_mat(streamed, expected);
+
+    ASSERT_THROW(stored.resize_strips(cv::Size(0, 10),
+        [](const cv::Mat &, int) {}), VCL::Exception);
+
+    stored.delete_image();
+}
+
+TEST_F(TDBImageTest, ResizeTo)
+{
+    VCL::TDBImage tdb("tdb/images/resize_source.tdb");
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 128);
+    tdb.write(cv_img_);
+
+    VCL::Rectangle rect(0, 0, cv_img_.cols / 3, cv_img_.rows / 3);
+
+    VCL::TDBImage full("tdb/images/resize_source.tdb");
+    full.read();
+    full.resize(rect);
+    cv::Mat expected = full.get_cvmat();
+
+    VCL::TDBImage source("tdb/images/resize_source.tdb");
+    source.resize_to("tdb/images/resize_target.tdb", rect.size());
+
+    VCL::TDBImage target("tdb/images/resize_target.tdb");
+    EXPECT_EQ(rect.height, target.get_image_height());
+    EXPECT_EQ(rect.width, target.get_image_width());
+    cv::Mat target_mat = target.get_cvmat();
+    compare_mat_mat(target_mat, expected);
+
+    source.delete_image();
+    target.delete_image();
+}
+
+TEST_F(TDBImageTest, ForEachTile)
+{
+    VCL::TDBImage tdb("tdb/images/each_tile.tdb");
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 384);
+    tdb.write(cv_img_);
+
+    std::mutex lock;
+    int tiles = 0;
+    int pixels = 0;
+
+    VCL::TDBImage stored("tdb/images/each_tile.tdb");
+    stored.for_each_tile([&](const cv::Mat &tile, const VCL::Rectangle &area) {
+        cv::Mat expected(cv_img_, area);
+        double diff = cv::norm(tile, expected, cv::NORM_INF);
+
+        std::lock_guard<std::mutex> guard(lock);
+        EXPECT_EQ(0, diff);
+        ++tiles;
+        pixels += area.area();
+    });
+
+    // Rows of 384 and 256 pixels, columns of 384, 384 and 256
+    EXPECT_EQ(6, tiles);
+    EXPECT_EQ(cv_img_.rows * cv_img_.cols, pixels);
+    EXPECT_FALSE(stored.has_data());
+
+    // Errors of any type leave the parallel region unchanged
+    ASSERT_THROW(stored.for_each_tile([](const cv::Mat &,
+        const VCL::Rectangle &) { throw std::runtime_error("tile"); }),
+        std::runtime_error);
+
+    stored.delete_image();
+}
+
+TEST_F(TDBImageTest, MapTiles)
+{
+    VCL::TDBImage tdb("tdb/images/map_source.tdb");
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 384);
+    tdb.write(cv_img_);
+
+    VCL::TDBImage source("tdb/images/map_source.tdb");
+    source.threshold_tiles("tdb/images/map_threshold.tdb", 200);
+
+    // The results can have another type than the image
+    source.map_tiles("tdb/images/map_gray.tdb",
+        [](const cv::Mat &tile, const VCL::Rectangle &) {
+            cv::Mat gray;
+            cv::cvtColor(tile, gray, cv::COLOR_BGR2GRAY);
+            return gray;
+        });
+
+    cv::Mat cv_threshold, cv_gray;
+    cv::threshold(cv_img_, cv_threshold, 200, 200, cv::THRESH_TOZERO);
+    cv::cvtColor(cv_img_, cv_gray, cv::COLOR_BGR2GRAY);
+
+    VCL::TDBImage threshold("tdb/images/map_threshold.tdb");
+    cv::Mat threshold_mat = threshold.get_cvmat();
+    compare_mat_mat(threshold_mat, cv_threshold);
+
+    VCL::TDBImage gray("tdb/images/map_gray.tdb");
+    EXPECT_EQ(CV_8UC1, gray.get_image_type());
+    cv::Mat gray_mat = gray.get_cvmat();
+    compare_mat_mat(gray_mat, cv_gray);
+
+    ASSERT_THROW(source.map_tiles("tdb/images/map_invalid.tdb",
+        [](const cv::Mat &, const VCL::Rectangle &) { return cv::Mat(); }),
+        VCL::Exception);
+
+    // Only results with one or three channels can be stored
+    ASSERT_THROW(source.map_tiles("tdb/images/map_channels.tdb",
+        [](const cv::Mat &tile, const VCL::Rectangle &) {
+            cv::Mat bgra;
+            cv::cvtColor(tile, bgra, cv::COLOR_BGR2BGRA);
+            return bgra;
+        }), VCL::Exception);
+
+    source.delete_image();
+    threshold.delete_image();
+    gray.delete_image();
+}
+
 TEST_F(TDBImageTest, Threshold)
 {
     VCL::TDBImage tdb(tdb_img_);
@@ -437,6 +933,86 @@ TEST_F(TDBImageTest, Threshold)
     compare_mat_mat(cv_bright, cv_img_);
 }
 
+TEST_F(TDBImageTest, ThresholdOnRead)
+{
+    cv::Mat cv_bright;
+    cv::threshold(cv_img_, cv_bright, 200, 200, cv::THRESH_TOZERO);
+
+    // Applied as the strips are read
+    VCL::TDBImage tdb(tdb_img_);
+    tdb.threshold(100);
+    tdb.threshold(200);
+    EXPECT_FALSE(tdb.has_data());
+
+    cv::Mat full_mat = tdb.get_cvmat();
+    compare_mat_mat(full_mat, cv_bright);
+
+    VCL::TDBImage area(tdb_img_);
+    area.threshold(200);
+    area.crop(rect_);
+    cv::Mat area_mat = area.get_cvmat();
+    cv::Mat expected(cv_bright, rect_);
+    compare_mat_mat(area_mat, expected);
+
+    // Other depths are thresholded with OpenCV
+    cv::Mat gray, wide, cv_wide;
+    cv::cvtColor(cv_img_, gray, cv::COLOR_BGR2GRAY);
+    gray.convertTo(wide, CV_16S, 100);
+    cv::threshold(wide, cv_wide, 12000, 12000, cv::THRESH_TOZERO);
+
+    VCL::TDBImage wide_tdb("tdb/images/threshold_wide.tdb");
+    wide_tdb.write(wide);
+
+    VCL::TDBImage stored("tdb/images/threshold_wide.tdb");
+    stored.threshold(12000);
+    cv::Mat stored_mat = stored.get_cvmat();
+    EXPECT_EQ(0, cv::norm(stored_mat, cv_wide, cv::NORM_INF));
+
+    stored.delete_image();
+}
+
+TEST_F(TDBImageTest, ThresholdThenStream)
+{
+    // The levels must not be read, as the threshold is of the image
+    VCL::TDBImage tdb("tdb/images/threshold_stream.tdb");
+    tdb.set_tiling(VCL::TilingPolicy::FIXED, 128);
+    tdb.set_pyramid_levels(2);
+    tdb.write(cv_img_);
+
+    cv::Mat cv_bright;
+    cv::threshold(cv_img_, cv_bright, 200, 200, cv::THRESH_TOZERO);
+
+    VCL::Rectangle rect(0, 0, cv_img_.cols / 3, cv_img_.rows / 3);
+
+    VCL::TDBImage full("tdb/images/threshold_stream.tdb");
+    full.threshold(200);
+    full.read();
+    full.resize(rect);
+    cv::Mat expected = full.get_cvmat();
+
+    VCL::TDBImage source("tdb/images/threshold_stream.tdb");
+    source.threshold(200);
+    source.resize_to("tdb/images/threshold_resized.tdb", rect.size());
+
+    VCL::TDBImage resized("tdb/images/threshold_resized.tdb");
+    cv::Mat resized_mat = resized.get_cvmat();
+    compare_mat_mat(resized_mat, expected);
+
+    std::mutex lock;
+    double diff = 0;
+    source.for_each_tile([&](const cv::Mat &tile, const VCL::Rectangle &area) {
+        cv::Mat bright(cv_bright, area);
+        double tile_diff = cv::norm(tile, bright, cv::NORM_INF);
+
+        std::lock_guard<std::mutex> guard(lock);
+        diff = std::max(diff, tile_diff);
+    });
+    EXPECT_EQ(0, diff);
+
+    source.delete_image();
+    resized.delete_image();
+}
+
 TEST_F(TDBImageTest, DeleteImage)
 {
     VCL::TDBImage tdb("tdb/images/operator_equals.tdb");
@@ -0,0 +1,95 @@
+/**
+ * @file   TDBMetadataCache_test.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "TDBMetadataCache.h"
+#include "TDBImage.h"
+#include "gtest/gtest.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <string>
+#include <vector>
+
+
+class TDBMetadataCacheTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        cache_ = &VCL::TDBMetadataCache::instance();
+        cache_->clear();
+        cv_img_ = cv::imread("images/large1.jpg", cv::IMREAD_ANYCOLOR);
+    }
+
+    VCL::TDBMetadataCache* cache_;
+    cv::Mat cv_img_;
+};
+
+
+TEST_F(TDBMetadataCacheTest, SetGetErase)
+{
+    std::vector<int64_t> properties = { 480, 640, 3 };
+    std::vector<int64_t> cached;
+
+    EXPECT_FALSE(cache_->get("tdb/images/cached.tdb", cached));
+
+    cache_->set("tdb/images/cached.tdb", properties);
+    ASSERT_TRUE(cache_->get("tdb/images/cached.tdb", cached));
+    EXPECT_EQ(properties, cached);
+    EXPECT_EQ(1, cache_->get_num_entries());
+
+    cache_->erase("tdb/images/cached.tdb");
+    EXPECT_FALSE(cache_->get("tdb/images/cached.tdb", cached));
+    EXPECT_EQ(0, cache_->get_num_entries());
+}
+
+TEST_F(TDBMetadataCacheTest, WriteAndRead)
+{
+    VCL::TDBImage tdb("tdb/images/cached_write.tdb");
+    tdb.write(cv_img_);
+
+    // Written properties are cached, so opening the image does no I/O
+    EXPECT_EQ(1, cache_->get_num_entries());
+    VCL::TDBImage cached("tdb/images/cached_write.tdb");
+    EXPECT_EQ(cv_img_.rows, cached.get_image_height());
+    EXPECT_EQ(cv_img_.type(), cached.get_image_type());
+
+    // Once cleared, the properties are read back with a single read
+    cache_->clear();
+    VCL::TDBImage stored("tdb/images/cached_write.tdb");
+    EXPECT_EQ(cv_img_.cols, stored.get_image_width());
+    EXPECT_EQ(cv_img_.channels(), stored.get_image_channels());
+    EXPECT_EQ(1, cache_->get_num_entries());
+
+    stored.delete_image();
+    EXPECT_EQ(0, cache_->get_num_entries());
+
+    VCL::TDBImage deleted("tdb/images/cached_write.tdb");
+    ASSERT_THROW(deleted.get_image_height(), VCL::Exception);
+}
@@ -0,0 +1,142 @@
+/**
+ * @file   TDBTileCache_test.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2017 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include "TDBTileCache.h"
+#include "TDBImage.h"
+#include "gtest/gtest.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <string>
+
+
+class TDBTileCacheTest : public ::testing::Test {
+
+protected:
+    virtual void SetUp() {
+        cache_ = &VCL::TDBTileCache::instance();
+        cache_->clear();
+        cache_->reset_counters();
+        cache_->set_capacity(size_t(64) << 20);
+
+        tdb_img_ = "tdb/images/tile_cache.tdb";
+        cv_img_ = cv::imread("images/large1.jpg", cv::IMREAD_ANYCOLOR);
+
+        VCL::TDBImage tdb(tdb_img_);
+        tdb.set_tiling(VCL::TilingPolicy::FIXED, 128);
+        tdb.write(cv_img_);
+    }
+
+    virtual void TearDown() {
+        cache_->set_capacity(0);
+        cache_->clear();
+
+        VCL::TDBImage tdb(tdb_img_);
+        tdb.delete_image();
+    }
+
+    VCL::TDBTileCache* cache_;
+    std::string tdb_img_;
+    cv::Mat cv_img_;
+};
+
+
+TEST_F(TDBTileCacheTest, ReadOverlappingAreas)
+{
+    // Rows 100 to 249 and columns 100 to 299 cover 2x3 tiles
+    VCL::Rectangle first_rect(100, 100, 200, 150);
+    VCL::TDBImage first(tdb_img_);
+    first.read(first_rect);
+    cv::Mat first_mat = first.get_cvmat();
+
+    EXPECT_EQ(0, cache_->get_hits());
+    EXPECT_EQ(6, cache_->get_misses());
+    EXPECT_EQ(6, cache_->get_num_entries());
+    EXPECT_EQ(0, cv::norm(first_mat, cv_img_(cv::Rect(100, 100, 200, 150)),
+        cv::NORM_INF));
+
+    // Rows 200 to 299 and columns 200 to 399 share 2 of their 6 tiles
+    VCL::Rectangle second_rect(200, 200, 200, 100);
+    VCL::TDBImage second(tdb_img_);
+    second.read(second_rect);
+    cv::Mat second_mat = second.get_cvmat();
+
+    EXPECT_EQ(2, cache_->get_hits());
+    EXPECT_EQ(10, cache_->get_misses());
+    EXPECT_EQ(0, cv::norm(second_mat, cv_img_(cv::Rect(200, 200, 200, 100)),
+        cv::NORM_INF));
+
+    // The whole image is assembled from cached and new tiles
+    VCL::TDBImage full(tdb_img_);
+    full.read();
+    cv::Mat full_mat = full.get_cvmat();
+    EXPECT_EQ(0, cv::norm(full_mat, cv_img_, cv::NORM_INF));
+    EXPECT_EQ(40, cache_->get_num_entries());
+}
+
+TEST_F(TDBTileCacheTest, ReadRewrittenImage)
+{
+    VCL::TDBImage first(tdb_img_);
+    first.read();
+    EXPECT_EQ(40, cache_->get_num_entries());
+
+    cv::Mat inverted = cv::Scalar::all(255) - cv_img_;
+    first.delete_image();
+    VCL::TDBImage rewrite(tdb_img_);
+    rewrite.set_tiling(VCL::TilingPolicy::FIXED, 128);
+    rewrite.write(inverted);
+
+    // The fragments changed, so none of the cached tiles are used
+    cache_->reset_counters();
+    VCL::TDBImage second(tdb_img_);
+    second.read();
+    cv::Mat second_mat = second.get_cvmat();
+
+    EXPECT_EQ(0, cache_->get_hits());
+    EXPECT_EQ(0, cv::norm(second_mat, inverted, cv::NORM_INF));
+}
+
+TEST_F(TDBTileCacheTest, ReadThreshold)
+{
+    cv::Mat cv_bright;
+    cv::threshold(cv_img_, cv_bright, 150, 150, cv::THRESH_TOZERO);
+
+    VCL::TDBImage bright(tdb_img_);
+    bright.threshold(150);
+    cv::Mat bright_mat = bright.get_cvmat();
+    EXPECT_EQ(0, cv::norm(bright_mat, cv_bright, cv::NORM_INF));
+
+    // The cached tiles are not thresholded
+    VCL::TDBImage full(tdb_img_);
+    cv::Mat full_mat = full.get_cvmat();
+    EXPECT_EQ(40, cache_->get_hits());
+    EXPECT_EQ(0, cv::norm(full_mat, cv_img_, cv::NORM_INF));
+}